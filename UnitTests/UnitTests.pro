@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += testlib
+QT       += testlib concurrent
 
 #QT       -= gui
 
@@ -16,7 +16,13 @@ TEMPLATE = app
 
 
 SOURCES += \
-    tst_colorlerp.cpp
+    main.cpp \
+    tst_colorlerp.cpp \
+    tst_rotate.cpp \
+    tst_flip.cpp \
+    tst_shift.cpp \
+    tst_scale.cpp \
+    tst_quantize.cpp
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
 
 win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../UtilsLib/release/ -lUtilsLib
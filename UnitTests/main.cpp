@@ -0,0 +1,18 @@
+int RunColorLerpTest(int argc, char *argv[]);
+int RunRotateTest(int argc, char *argv[]);
+int RunFlipTest(int argc, char *argv[]);
+int RunShiftTest(int argc, char *argv[]);
+int RunScaleTest(int argc, char *argv[]);
+int RunQuantizeTest(int argc, char *argv[]);
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+    failures += RunColorLerpTest(argc, argv);
+    failures += RunRotateTest(argc, argv);
+    failures += RunFlipTest(argc, argv);
+    failures += RunShiftTest(argc, argv);
+    failures += RunScaleTest(argc, argv);
+    failures += RunQuantizeTest(argc, argv);
+    return failures;
+}
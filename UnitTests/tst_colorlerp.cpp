@@ -1,5 +1,6 @@
 #include <QString>
 #include <QtTest>
+#include <QVector>
 #include "pb_math.h"
 #include <exception>
 
@@ -20,6 +21,13 @@ private Q_SLOTS:
     void test_lerp_with_full_interpolation_should_return_second_color();
     void test_lerp_with_interpolation_less_than_zero_should_clamp_to_first_color();
     void test_lerp_with_interpolation_greater_than_one_should_not_clamp_to_second_color();
+    void test_rgb_lerp_should_match_color_lerp_data();
+    void test_rgb_lerp_should_match_color_lerp();
+    void test_rgb_lerp_should_keep_premultiplied_valid();
+    void test_gradient_ramp_should_match_rgb_lerp();
+    void test_gradient_ramp_should_include_both_ends();
+    void benchmark_color_lerp();
+    void benchmark_gradient_ramp();
 };
 
 void ColorLerpTest::test_lerp_to_same_color_should_return_same_color()
@@ -52,6 +60,85 @@ void ColorLerpTest::test_lerp_with_interpolation_less_than_zero_should_clamp_to_
     QVERIFY(lerpedColor == this->blackColor);
 }
 
-QTEST_APPLESS_MAIN(ColorLerpTest)
+void ColorLerpTest::test_rgb_lerp_should_match_color_lerp_data()
+{
+    QTest::addColumn<float>("t");
+    QTest::addColumn<int>("weight");
+
+    QTest::newRow("start") << 0.0f << 0;
+    QTest::newRow("quarter") << 0.25f << 64;
+    QTest::newRow("half") << 0.5f << 128;
+    QTest::newRow("end") << 1.0f << 256;
+    QTest::newRow("before start") << -1.0f << -256;
+    QTest::newRow("past end") << 2.0f << 512;
+}
+
+void ColorLerpTest::test_rgb_lerp_should_match_color_lerp()
+{
+    QFETCH(float, t);
+    QFETCH(int, weight);
+
+    QColor from(10, 200, 30, 255);
+    QColor to(250, 0, 90, 128);
+    QCOMPARE(RgbLerp(from.rgba(), to.rgba(), weight), ColorLerp(from, to, t).rgba());
+}
+
+void ColorLerpTest::test_rgb_lerp_should_keep_premultiplied_valid()
+{
+    QRgb from = qPremultiply(qRgba(255, 40, 0, 200));
+    QRgb to = qPremultiply(qRgba(0, 255, 120, 30));
+    for (int t = 0; t <= 256; ++t) {
+        QRgb c = RgbLerp(from, to, t);
+        QVERIFY(qRed(c) <= qAlpha(c));
+        QVERIFY(qGreen(c) <= qAlpha(c));
+        QVERIFY(qBlue(c) <= qAlpha(c));
+    }
+}
+
+void ColorLerpTest::test_gradient_ramp_should_match_rgb_lerp()
+{
+    QRgb from = qRgba(12, 34, 56, 78);
+    QRgb to = qRgba(250, 140, 3, 255);
+    for (int n = 1; n < 19; ++n) {
+        QVector<QRgb> ramp(n);
+        GradientRamp(from, to, n, ramp.data());
+        for (int i = 0; i < n; ++i) {
+            int weight = n > 1 ? (i * 256 + (n - 1) / 2) / (n - 1) : 0;
+            QCOMPARE(ramp[i], RgbLerp(from, to, weight));
+        }
+    }
+}
+
+void ColorLerpTest::test_gradient_ramp_should_include_both_ends()
+{
+    QRgb ramp[10];
+    GradientRamp(this->blackColor.rgba(), this->whiteColor.rgba(), 10, ramp);
+    QCOMPARE(ramp[0], this->blackColor.rgba());
+    QCOMPARE(ramp[9], this->whiteColor.rgba());
+}
+
+void ColorLerpTest::benchmark_color_lerp()
+{
+    QRgb ramp[30];
+    QBENCHMARK {
+        for (int i = 0; i < 30; ++i) {
+            ramp[i] = ColorLerp(this->blackColor, this->whiteColor, i / 29.0f).rgba();
+        }
+    }
+}
+
+void ColorLerpTest::benchmark_gradient_ramp()
+{
+    QRgb ramp[30];
+    QBENCHMARK {
+        GradientRamp(this->blackColor.rgba(), this->whiteColor.rgba(), 30, ramp);
+    }
+}
+
+int RunColorLerpTest(int argc, char *argv[])
+{
+    ColorLerpTest test;
+    return QTest::qExec(&test, argc, argv);
+}
 
 #include "tst_colorlerp.moc"
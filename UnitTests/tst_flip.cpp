@@ -0,0 +1,71 @@
+#include <QImage>
+#include <QtTest>
+#include "pb_image.h"
+
+class FlipTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    FlipTest() {}
+
+private:
+    static QImage patternImage(int width, int height, QImage::Format format);
+
+private Q_SLOTS:
+    void test_flip_in_place_should_match_mirrored_data();
+    void test_flip_in_place_should_match_mirrored();
+    void test_flip_twice_should_return_same_image();
+};
+
+QImage FlipTest::patternImage(int width, int height, QImage::Format format)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, qRgba(x * 7, y * 13, (x ^ y) & 0xff, 255));
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+void FlipTest::test_flip_in_place_should_match_mirrored_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("argb32 premultiplied") << int(QImage::Format_ARGB32_Premultiplied);
+    QTest::newRow("rgb16") << int(QImage::Format_RGB16);
+    QTest::newRow("indexed8") << int(QImage::Format_Indexed8);
+    QTest::newRow("mono") << int(QImage::Format_Mono);
+}
+
+void FlipTest::test_flip_in_place_should_match_mirrored()
+{
+    QFETCH(int, format);
+
+    QImage image = patternImage(37, 13, QImage::Format(format));
+    for (int i = 1; i < 4; ++i) {
+        bool horizontal = i & 1;
+        bool vertical = i & 2;
+        QImage flipped = image;
+        FlipInPlace(&flipped, horizontal, vertical);
+        QCOMPARE(flipped, image.mirrored(horizontal, vertical));
+    }
+}
+
+void FlipTest::test_flip_twice_should_return_same_image()
+{
+    QImage image = patternImage(64, 33, QImage::Format_ARGB32_Premultiplied);
+    QImage flipped = image;
+    FlipInPlace(&flipped, true, true);
+    FlipInPlace(&flipped, true, true);
+    QCOMPARE(flipped, image);
+}
+
+int RunFlipTest(int argc, char *argv[])
+{
+    FlipTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_flip.moc"
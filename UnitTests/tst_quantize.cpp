@@ -0,0 +1,184 @@
+#include <QImage>
+#include <QtTest>
+#include <climits>
+#include "pb_quantize.h"
+
+class QuantizeTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    QuantizeTest() {}
+
+private:
+    static QImage clusterImage(int width, int height, const QVector<QRgb> &centers);
+    static QImage gradientImage(int width, int height);
+    // 1024 always, 4096 when PB_LARGE_BENCHMARKS is set.
+    static void benchmarkSizes();
+
+private Q_SLOTS:
+    void test_quantize_few_colors_should_be_exact_data();
+    void test_quantize_few_colors_should_be_exact();
+    void test_quantize_should_find_clusters_data();
+    void test_quantize_should_find_clusters();
+    void test_quantize_should_keep_color_limit();
+    void test_quantize_should_skip_transparent_pixels();
+    void benchmark_quantize_median_cut_data();
+    void benchmark_quantize_median_cut();
+    void benchmark_quantize_octree_data();
+    void benchmark_quantize_octree();
+};
+
+// Each pixel a center of |centers| shifted by 0 to 6 on every channel.
+QImage QuantizeTest::clusterImage(int width, int height, const QVector<QRgb> &centers)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            QRgb c = centers[(x * 7 + y * 3) % centers.size()];
+            int d = (x * 5 + y * 11) % 7;
+            image.setPixel(x, y, qRgb(qRed(c) + d, qGreen(c) + 6 - d, qBlue(c) + (x + y) % 7));
+        }
+    }
+    return image;
+}
+
+QImage QuantizeTest::gradientImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, qRgb(x * 255 / width, y * 255 / height, (x ^ y) & 0xff));
+        }
+    }
+    return image;
+}
+
+void QuantizeTest::benchmarkSizes()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("1024x1024") << 1024;
+    if (qEnvironmentVariableIsSet("PB_LARGE_BENCHMARKS")) {
+        QTest::newRow("4096x4096") << 4096;
+    }
+}
+
+void QuantizeTest::test_quantize_few_colors_should_be_exact_data()
+{
+    QTest::addColumn<int>("quantizer");
+
+    QTest::newRow("median cut") << int(QUANTIZER_MEDIAN_CUT);
+    QTest::newRow("octree") << int(QUANTIZER_OCTREE);
+}
+
+void QuantizeTest::test_quantize_few_colors_should_be_exact()
+{
+    QFETCH(int, quantizer);
+
+    QImage image(40, 30, QImage::Format_ARGB32);
+    const QRgb colors[] = {0xffffffff, 0xff102030, 0xffff0000, 0xff00ff00};
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, colors[(x / 3 + y) % 4]);
+        }
+    }
+    QVector<QRgb> expected = {0xff102030, 0xffff0000, 0xff00ff00, 0xffffffff};
+    QCOMPARE(QuantizePalette(image, 16, QUANTIZER_ENUM(quantizer)), expected);
+}
+
+void QuantizeTest::test_quantize_should_find_clusters_data()
+{
+    QTest::addColumn<int>("quantizer");
+    QTest::addColumn<int>("kmeans_passes");
+
+    QTest::newRow("median cut") << int(QUANTIZER_MEDIAN_CUT) << 0;
+    QTest::newRow("median cut k-means") << int(QUANTIZER_MEDIAN_CUT) << 4;
+    QTest::newRow("octree") << int(QUANTIZER_OCTREE) << 0;
+    QTest::newRow("octree k-means") << int(QUANTIZER_OCTREE) << 4;
+}
+
+void QuantizeTest::test_quantize_should_find_clusters()
+{
+    QFETCH(int, quantizer);
+    QFETCH(int, kmeans_passes);
+
+    QVector<QRgb> centers;
+    for (int i = 0; i < 8; ++i) {
+        centers.push_back(qRgb(i & 1 ? 220 : 20, i & 2 ? 220 : 20, i & 4 ? 220 : 20));
+    }
+    QImage image = clusterImage(128, 96, centers);
+    QVector<QRgb> palette = QuantizePalette(image, 8, QUANTIZER_ENUM(quantizer), kmeans_passes);
+    QCOMPARE(palette.size(), 8);
+    for (QRgb c : centers) {
+        int nearest = INT_MAX;
+        for (QRgb p : palette) {
+            nearest = qMin(nearest, qAbs(qRed(p) - qRed(c) - 3) + qAbs(qGreen(p) - qGreen(c) - 3) +
+                                        qAbs(qBlue(p) - qBlue(c) - 3));
+        }
+        QVERIFY(nearest <= 6);
+    }
+}
+
+void QuantizeTest::test_quantize_should_keep_color_limit()
+{
+    QImage image = gradientImage(300, 200);
+    for (int colors : {2, 16, 64, 256}) {
+        QVector<QRgb> median = QuantizePalette(image, colors, QUANTIZER_MEDIAN_CUT);
+        QVector<QRgb> octree = QuantizePalette(image, colors, QUANTIZER_OCTREE);
+        QVERIFY(median.size() >= colors / 2 && median.size() <= colors);
+        QVERIFY(octree.size() >= colors / 2 && octree.size() <= colors);
+        for (int i = 1; i < median.size(); ++i) {
+            QVERIFY(qGray(median[i - 1]) <= qGray(median[i]));
+        }
+    }
+}
+
+void QuantizeTest::test_quantize_should_skip_transparent_pixels()
+{
+    QImage image(16, 16, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    image.setPixel(3, 4, 0xff336699);
+    image.setPixel(5, 4, 0x80081018);
+    QVector<QRgb> palette = QuantizePalette(image, 4, QUANTIZER_MEDIAN_CUT);
+    QCOMPARE(palette.size(), 2);
+    QCOMPARE(palette.last(), 0xff336699);
+}
+
+void QuantizeTest::benchmark_quantize_median_cut_data()
+{
+    benchmarkSizes();
+}
+
+void QuantizeTest::benchmark_quantize_median_cut()
+{
+    QFETCH(int, size);
+
+    QImage image = gradientImage(size, size);
+    QBENCHMARK {
+        QuantizePalette(image, 64, QUANTIZER_MEDIAN_CUT);
+    }
+}
+
+void QuantizeTest::benchmark_quantize_octree_data()
+{
+    benchmarkSizes();
+}
+
+void QuantizeTest::benchmark_quantize_octree()
+{
+    QFETCH(int, size);
+
+    QImage image = gradientImage(size, size);
+    QBENCHMARK {
+        QuantizePalette(image, 64, QUANTIZER_OCTREE);
+    }
+}
+
+int RunQuantizeTest(int argc, char *argv[])
+{
+    QuantizeTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_quantize.moc"
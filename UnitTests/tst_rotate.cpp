@@ -0,0 +1,161 @@
+#include <QImage>
+#include <QPainter>
+#include <QTransform>
+#include <QtTest>
+#include "pb_image.h"
+#include "pb_scale.h"
+
+class RotateTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    RotateTest() {}
+
+private:
+    static QImage patternImage(int width, int height, QImage::Format format);
+    static QImage rotatedWithPainter(const QImage &image, bool cw);
+
+private Q_SLOTS:
+    void test_rotate_should_match_transformed_data();
+    void test_rotate_should_match_transformed();
+    void test_rotate_indexed_should_keep_color_table();
+    void test_rotate_cw_then_ccw_should_return_same_image();
+    void test_rotsprite_should_only_use_source_colors();
+    void test_rotsprite_quarter_turn_should_be_exact();
+    void benchmark_rotate_with_painter();
+    void benchmark_rotate_quarter();
+    void benchmark_rotsprite();
+    void benchmark_rotsprite_preview();
+};
+
+QImage RotateTest::patternImage(int width, int height, QImage::Format format)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, qRgba(x * 7, y * 13, (x ^ y) & 0xff, 255));
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+// The path ImageEditWidget used before RotateQuarter.
+QImage RotateTest::rotatedWithPainter(const QImage &image, bool cw)
+{
+    QTransform t;
+    t.rotate(cw ? 90 : -90);
+    QImage i = QImage(image.height(), image.width(), image.format());
+    QPainter p(&i);
+    p.drawImage(i.rect(), image.transformed(t));
+    return i;
+}
+
+void RotateTest::test_rotate_should_match_transformed_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<bool>("cw");
+
+    QTest::newRow("1x1 cw") << 1 << 1 << true;
+    QTest::newRow("37x13 cw") << 37 << 13 << true;
+    QTest::newRow("37x13 ccw") << 37 << 13 << false;
+    QTest::newRow("64x64 cw") << 64 << 64 << true;
+    QTest::newRow("65x33 ccw") << 65 << 33 << false;
+}
+
+void RotateTest::test_rotate_should_match_transformed()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(bool, cw);
+
+    QImage image = patternImage(width, height, QImage::Format_ARGB32_Premultiplied);
+    QImage expected = image.transformed(QTransform().rotate(cw ? 90 : -90));
+    QCOMPARE(RotateQuarter(image, cw), expected);
+}
+
+void RotateTest::test_rotate_indexed_should_keep_color_table()
+{
+    QImage image = patternImage(19, 6, QImage::Format_ARGB32)
+                       .convertToFormat(QImage::Format_Indexed8);
+    QImage rotated = RotateQuarter(image, true);
+    QCOMPARE(rotated.format(), QImage::Format_Indexed8);
+    QCOMPARE(rotated.colorTable(), image.colorTable());
+    QCOMPARE(rotated.pixelIndex(5, 0), image.pixelIndex(0, 0));
+    QCOMPARE(rotated.pixelIndex(0, 18), image.pixelIndex(18, 5));
+}
+
+void RotateTest::test_rotate_cw_then_ccw_should_return_same_image()
+{
+    QImage image = patternImage(101, 57, QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(RotateQuarter(RotateQuarter(image, true), false), image);
+}
+
+void RotateTest::test_rotsprite_should_only_use_source_colors()
+{
+    QImage image(24, 16, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    for (int y = 3; y < 12; ++y) {
+        for (int x = 3; x < 20; ++x) {
+            image.setPixel(x, y, (x + y) % 5 ? 0xff00ff00 : 0xffff0000);
+        }
+    }
+    for (bool preview : {false, true}) {
+        QImage rotated = RotatePixelArt(image, 30, preview);
+        QCOMPARE(rotated.size(), QSize(29, 26));
+        for (int y = 0; y < rotated.height(); ++y) {
+            for (int x = 0; x < rotated.width(); ++x) {
+                QRgb c = rotated.pixel(x, y);
+                QVERIFY(c == 0 || c == 0xff00ff00 || c == 0xffff0000);
+            }
+        }
+    }
+}
+
+void RotateTest::test_rotsprite_quarter_turn_should_be_exact()
+{
+    QImage image = patternImage(37, 13, QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(RotatePixelArt(image, -270), RotateQuarter(image, true));
+    QCOMPARE(RotatePixelArt(image, 360), image);
+}
+
+void RotateTest::benchmark_rotate_with_painter()
+{
+    QImage image = patternImage(2048, 2048, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        rotatedWithPainter(image, true);
+    }
+}
+
+void RotateTest::benchmark_rotate_quarter()
+{
+    QImage image = patternImage(2048, 2048, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        RotateQuarter(image, true);
+    }
+}
+
+void RotateTest::benchmark_rotsprite()
+{
+    QImage image = patternImage(256, 256, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        RotatePixelArt(image, 30);
+    }
+}
+
+void RotateTest::benchmark_rotsprite_preview()
+{
+    QImage image = patternImage(256, 256, QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        RotatePixelArt(image, 30, true);
+    }
+}
+
+int RunRotateTest(int argc, char *argv[])
+{
+    RotateTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_rotate.moc"
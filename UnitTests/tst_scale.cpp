@@ -0,0 +1,161 @@
+#include <QImage>
+#include <QThreadPool>
+#include <QtTest>
+#include "pb_scale.h"
+
+class ScaleTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScaleTest() {}
+
+private:
+    static QImage patternImage(int width, int height);
+    // '#' is black, anything else white.
+    static QImage fromRows(const QStringList &rows);
+
+private Q_SLOTS:
+    void test_nearest_should_repeat_pixels_data();
+    void test_nearest_should_repeat_pixels();
+    void test_scale2x_should_match_expected();
+    void test_scale3x_should_match_expected();
+    void test_scale4x_should_be_scale2x_twice();
+    void test_indexed_should_keep_color_table();
+    void test_bands_should_match_single_band_data();
+    void test_bands_should_match_single_band();
+};
+
+QImage ScaleTest::patternImage(int width, int height)
+{
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, (x / 3 + y / 2) % 3 ? qRgb(x * 5, y * 3, 90) : qRgb(200, 40, 40));
+        }
+    }
+    return image;
+}
+
+QImage ScaleTest::fromRows(const QStringList &rows)
+{
+    QImage image(rows.first().size(), rows.size(), QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            image.setPixel(x, y, rows[y][x] == '#' ? 0xff000000 : 0xffffffff);
+        }
+    }
+    return image;
+}
+
+void ScaleTest::test_nearest_should_repeat_pixels_data()
+{
+    QTest::addColumn<int>("factor");
+
+    QTest::newRow("2x") << 2;
+    QTest::newRow("3x") << 3;
+}
+
+void ScaleTest::test_nearest_should_repeat_pixels()
+{
+    QFETCH(int, factor);
+
+    QImage image = patternImage(13, 7);
+    QImage scaled = ScalePixelArt(image, SCALER_NEAREST, factor);
+    QCOMPARE(scaled.size(), image.size() * factor);
+    QCOMPARE(scaled.format(), image.format());
+    for (int y = 0; y < scaled.height(); ++y) {
+        for (int x = 0; x < scaled.width(); ++x) {
+            QCOMPARE(scaled.pixel(x, y), image.pixel(x / factor, y / factor));
+        }
+    }
+}
+
+void ScaleTest::test_scale2x_should_match_expected()
+{
+    QImage image = fromRows({"#..",
+                             ".#.",
+                             "..#"});
+    QImage expected = fromRows({"##....",
+                                "#.#...",
+                                ".###..",
+                                "..###.",
+                                "...#.#",
+                                "....##"});
+    QCOMPARE(ScalePixelArt(image, SCALER_SCALE_NX, 2), expected);
+}
+
+void ScaleTest::test_scale3x_should_match_expected()
+{
+    QImage image = fromRows({"#..",
+                             ".#.",
+                             "..#"});
+    QImage expected = fromRows({"###......",
+                                "##.#.....",
+                                "#..#.....",
+                                ".#####...",
+                                "...###...",
+                                "...#####.",
+                                ".....#..#",
+                                ".....#.##",
+                                "......###"});
+    QCOMPARE(ScalePixelArt(image, SCALER_SCALE_NX, 3), expected);
+}
+
+void ScaleTest::test_scale4x_should_be_scale2x_twice()
+{
+    QImage image = patternImage(17, 11);
+    QImage twice = ScalePixelArt(ScalePixelArt(image, SCALER_SCALE_NX, 2), SCALER_SCALE_NX, 2);
+    QCOMPARE(ScalePixelArt(image, SCALER_SCALE_NX, 4), twice);
+}
+
+void ScaleTest::test_indexed_should_keep_color_table()
+{
+    QImage image = fromRows({"#..",
+                             ".#.",
+                             "..#"}).convertToFormat(QImage::Format_Indexed8);
+    for (SCALER_ENUM scaler : {SCALER_NEAREST, SCALER_SCALE_NX, SCALER_HQX, SCALER_XBR}) {
+        QImage scaled = ScalePixelArt(image, scaler, 2);
+        QCOMPARE(scaled.format(), QImage::Format_Indexed8);
+        QCOMPARE(scaled.colorTable(), image.colorTable());
+        QCOMPARE(scaled.pixelIndex(0, 0), image.pixelIndex(0, 0));
+        QCOMPARE(scaled.pixelIndex(5, 5), image.pixelIndex(2, 2));
+    }
+}
+
+void ScaleTest::test_bands_should_match_single_band_data()
+{
+    QTest::addColumn<int>("scaler");
+    QTest::addColumn<int>("factor");
+
+    QTest::newRow("nearest 3x") << int(SCALER_NEAREST) << 3;
+    QTest::newRow("scale2x") << int(SCALER_SCALE_NX) << 2;
+    QTest::newRow("scale3x") << int(SCALER_SCALE_NX) << 3;
+    QTest::newRow("hqx 2x") << int(SCALER_HQX) << 2;
+    QTest::newRow("xbr 4x") << int(SCALER_XBR) << 4;
+}
+
+void ScaleTest::test_bands_should_match_single_band()
+{
+    QFETCH(int, scaler);
+    QFETCH(int, factor);
+
+    // Bands follow the pool size, 8 threads split 150 rows at every 18 or 19.
+    QImage image = patternImage(40, 150);
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int threads = pool->maxThreadCount();
+    pool->setMaxThreadCount(1);
+    QImage single = ScalePixelArt(image, SCALER_ENUM(scaler), factor);
+    pool->setMaxThreadCount(8);
+    QImage banded = ScalePixelArt(image, SCALER_ENUM(scaler), factor);
+    pool->setMaxThreadCount(threads);
+    QCOMPARE(banded, single);
+}
+
+int RunScaleTest(int argc, char *argv[])
+{
+    ScaleTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_scale.moc"
@@ -0,0 +1,68 @@
+#include <QImage>
+#include <QtTest>
+#include "pb_image.h"
+
+class ShiftTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    ShiftTest() {}
+
+private:
+    static QImage patternImage(int width, int height, QImage::Format format);
+
+private Q_SLOTS:
+    void test_shift_in_place_should_wrap_around_data();
+    void test_shift_in_place_should_wrap_around();
+    void test_shift_by_whole_size_should_keep_image();
+};
+
+QImage ShiftTest::patternImage(int width, int height, QImage::Format format)
+{
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            image.setPixel(x, y, qRgba(x * 7, y * 13, (x ^ y) & 0xff, 255));
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+void ShiftTest::test_shift_in_place_should_wrap_around_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("argb32 premultiplied") << int(QImage::Format_ARGB32_Premultiplied);
+    QTest::newRow("indexed8") << int(QImage::Format_Indexed8);
+    QTest::newRow("mono") << int(QImage::Format_Mono);
+}
+
+void ShiftTest::test_shift_in_place_should_wrap_around()
+{
+    QFETCH(int, format);
+
+    QImage image = patternImage(37, 13, QImage::Format(format));
+    QImage shifted = image;
+    ShiftInPlace(&shifted, -3, 40);
+    QCOMPARE(shifted.pixel(34, 1), image.pixel(0, 0));
+    QCOMPARE(shifted.pixel(0, 0), image.pixel(3, 12));
+    ShiftInPlace(&shifted, 3, -40);
+    QCOMPARE(shifted, image);
+}
+
+void ShiftTest::test_shift_by_whole_size_should_keep_image()
+{
+    QImage image = patternImage(37, 13, QImage::Format_ARGB32_Premultiplied);
+    QImage shifted = image;
+    ShiftInPlace(&shifted, 37, -26);
+    QCOMPARE(shifted, image);
+}
+
+int RunShiftTest(int argc, char *argv[])
+{
+    ShiftTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_shift.moc"
@@ -5,12 +5,18 @@
 #-------------------------------------------------
 
 #QT       -= gui
-QT += gui
+QT += gui concurrent
 
 TARGET = UtilsLib
 TEMPLATE = lib
 CONFIG += staticlib
 
-SOURCES += pb_math.cpp
+SOURCES += pb_math.cpp \
+    pb_image.cpp \
+    pb_scale.cpp \
+    pb_quantize.cpp
 
-HEADERS += pb_math.h
+HEADERS += pb_math.h \
+    pb_image.h \
+    pb_scale.h \
+    pb_quantize.h
@@ -0,0 +1,307 @@
+#include "pb_image.h"
+
+#include <QTransform>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PB_IMAGE_SSE2
+#endif
+
+namespace {
+
+// Source and destination rows of a block stay in L1 while it is copied.
+const int kRotateBlock = 32;
+
+template <typename T>
+inline T *RotatedPixel(uchar *dst, int dst_bpl, int w, int h, int x, int y,
+                       bool cw) {
+  return cw ? reinterpret_cast<T *>(dst + x * dst_bpl) + (h - 1 - y)
+            : reinterpret_cast<T *>(dst + (w - 1 - x) * dst_bpl) + y;
+}
+
+// Walks the source a column at a time so the destination is written along
+// its rows.
+template <typename T>
+void RotateRect(const uchar *src, int src_bpl, uchar *dst, int dst_bpl, int w,
+                int h, int x0, int y0, int x1, int y1, bool cw) {
+  for (int by = y0; by < y1; by += kRotateBlock) {
+    int ey = (std::min)(by + kRotateBlock, y1);
+    for (int bx = x0; bx < x1; bx += kRotateBlock) {
+      int ex = (std::min)(bx + kRotateBlock, x1);
+      for (int x = bx; x < ex; ++x) {
+        for (int y = by; y < ey; ++y) {
+          *RotatedPixel<T>(dst, dst_bpl, w, h, x, y, cw) =
+              reinterpret_cast<const T *>(src + y * src_bpl)[x];
+        }
+      }
+    }
+  }
+}
+
+#ifdef PB_IMAGE_SSE2
+// 32 bit pixels are moved as transposed 4x4 tiles. Returns the width and
+// height of the area covered, the rest is left to RotateRect.
+QSize RotateRect32(const uchar *src, int src_bpl, uchar *dst, int dst_bpl,
+                   int w, int h, bool cw) {
+  const int w4 = w & ~3;
+  const int h4 = h & ~3;
+  for (int by = 0; by < h4; by += kRotateBlock) {
+    int ey = (std::min)(by + kRotateBlock, h4);
+    for (int bx = 0; bx < w4; bx += kRotateBlock) {
+      int ex = (std::min)(bx + kRotateBlock, w4);
+      for (int y = by; y < ey; y += 4) {
+        const uchar *row = src + y * src_bpl;
+        for (int x = bx; x < ex; x += 4) {
+          const __m128i *s = reinterpret_cast<const __m128i *>(
+              reinterpret_cast<const quint32 *>(row) + x);
+          __m128i r0 = _mm_loadu_si128(s);
+          __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+              reinterpret_cast<const uchar *>(s) + src_bpl));
+          __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+              reinterpret_cast<const uchar *>(s) + 2 * src_bpl));
+          __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+              reinterpret_cast<const uchar *>(s) + 3 * src_bpl));
+          __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+          __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+          __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+          __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+          // Column j of the tile, top to bottom.
+          __m128i c[4] = {_mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+                          _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3)};
+          for (int j = 0; j < 4; ++j) {
+            if (cw) {
+              // Lands right to left on the destination row.
+              _mm_storeu_si128(
+                  reinterpret_cast<__m128i *>(
+                      RotatedPixel<quint32>(dst, dst_bpl, w, h, x + j, y + 3, cw)),
+                  _mm_shuffle_epi32(c[j], _MM_SHUFFLE(0, 1, 2, 3)));
+            } else {
+              _mm_storeu_si128(
+                  reinterpret_cast<__m128i *>(
+                      RotatedPixel<quint32>(dst, dst_bpl, w, h, x + j, y, cw)),
+                  c[j]);
+            }
+          }
+        }
+      }
+    }
+  }
+  return QSize(w4, h4);
+}
+#endif
+
+void SwapRows(uchar *a, uchar *b, int bytes) {
+  int i = 0;
+#ifdef PB_IMAGE_SSE2
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(a + i), vb);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(b + i), va);
+  }
+#endif
+  for (; i < bytes; ++i) {
+    std::swap(a[i], b[i]);
+  }
+}
+
+void ReverseRow32(quint32 *row, int width) {
+  int i = 0;
+  int j = width;
+#ifdef PB_IMAGE_SSE2
+  // Swaps four pixels from each end per step, reversed on the way.
+  for (; j - i >= 8; i += 4, j -= 4) {
+    __m128i *left = reinterpret_cast<__m128i *>(row + i);
+    __m128i *right = reinterpret_cast<__m128i *>(row + j - 4);
+    __m128i l = _mm_loadu_si128(left);
+    __m128i r = _mm_loadu_si128(right);
+    _mm_storeu_si128(left, _mm_shuffle_epi32(r, _MM_SHUFFLE(0, 1, 2, 3)));
+    _mm_storeu_si128(right, _mm_shuffle_epi32(l, _MM_SHUFFLE(0, 1, 2, 3)));
+  }
+#endif
+  std::reverse(row + i, row + j);
+}
+
+// Brings |shift| into [0, size) and returns it as the smaller of the two
+// equivalent moves, negative when going back is shorter.
+int WrapShift(int shift, int size) {
+  shift %= size;
+  if (shift < 0) {
+    shift += size;
+  }
+  return shift > size / 2 ? shift - size : shift;
+}
+
+// Rotates |count| blocks of |block| bytes by |shift| blocks towards the end,
+// parking the blocks that wrap in |scratch|.
+void RotateBlocks(uchar *data, int count, int block, int shift, uchar *scratch) {
+  if (shift > 0) {
+    const int moved = (count - shift) * block;
+    memcpy(scratch, data + moved, shift * block);
+    memmove(data + shift * block, data, moved);
+    memcpy(data, scratch, shift * block);
+  } else if (shift < 0) {
+    shift = -shift;
+    const int moved = (count - shift) * block;
+    memcpy(scratch, data, shift * block);
+    memmove(data, data + shift * block, moved);
+    memcpy(data + moved, scratch, shift * block);
+  }
+}
+
+// Moves every row of |image| |shift| rows down, wrapping around. Rows go
+// straight to their place along the cycles of the rotation, only the first
+// row of each cycle waits in |scratch|.
+void RotateRows(QImage *image, int shift, uchar *scratch) {
+  const int h = image->height();
+  const int bpl = image->bytesPerLine();
+  uchar *bits = image->bits();
+  if (shift < 0) {
+    shift += h;
+  }
+  int cycles = h;
+  for (int b = shift; b != 0;) {
+    int t = cycles % b;
+    cycles = b;
+    b = t;
+  }
+  for (int start = 0; start < cycles; ++start) {
+    memcpy(scratch, bits + start * bpl, bpl);
+    int to = start;
+    int from = (to - shift + h) % h;
+    while (from != start) {
+      memcpy(bits + to * bpl, bits + from * bpl, bpl);
+      to = from;
+      from = (to - shift + h) % h;
+    }
+    memcpy(bits + to * bpl, scratch, bpl);
+  }
+}
+
+}  // namespace
+
+QImage RotateQuarter(const QImage &image, bool cw) {
+  if (image.isNull()) {
+    return QImage();
+  }
+  const int depth = image.depth();
+  if (depth != 8 && depth != 16 && depth != 32) {
+    return image.transformed(QTransform().rotate(cw ? 90 : -90));
+  }
+
+  const int w = image.width();
+  const int h = image.height();
+  QImage out(h, w, image.format());
+  if (out.isNull()) {
+    return out;
+  }
+  if (depth == 8) {
+    out.setColorTable(image.colorTable());
+  }
+
+  const uchar *src = image.constBits();
+  const int src_bpl = image.bytesPerLine();
+  uchar *dst = out.bits();
+  const int dst_bpl = out.bytesPerLine();
+
+  switch (depth) {
+    case 8:
+      RotateRect<quint8>(src, src_bpl, dst, dst_bpl, w, h, 0, 0, w, h, cw);
+      break;
+    case 16:
+      RotateRect<quint16>(src, src_bpl, dst, dst_bpl, w, h, 0, 0, w, h, cw);
+      break;
+    default: {
+#ifdef PB_IMAGE_SSE2
+      QSize done = RotateRect32(src, src_bpl, dst, dst_bpl, w, h, cw);
+      // Right strip, then the bottom strip under the covered area.
+      RotateRect<quint32>(src, src_bpl, dst, dst_bpl, w, h, done.width(), 0,
+                          w, h, cw);
+      RotateRect<quint32>(src, src_bpl, dst, dst_bpl, w, h, 0, done.height(),
+                          done.width(), h, cw);
+#else
+      RotateRect<quint32>(src, src_bpl, dst, dst_bpl, w, h, 0, 0, w, h, cw);
+#endif
+      break;
+    }
+  }
+  return out;
+}
+
+void FlipInPlace(QImage *image, bool horizontal, bool vertical) {
+  if (image->isNull() || (!horizontal && !vertical)) {
+    return;
+  }
+  const int depth = image->depth();
+  if (depth != 8 && depth != 16 && depth != 32) {
+    *image = image->mirrored(horizontal, vertical);
+    return;
+  }
+
+  const int w = image->width();
+  const int h = image->height();
+  const int row_bytes = w * depth / 8;
+  if (vertical) {
+    for (int y = 0; y < h / 2; ++y) {
+      SwapRows(image->scanLine(y), image->scanLine(h - 1 - y), row_bytes);
+    }
+  }
+  if (horizontal) {
+    for (int y = 0; y < h; ++y) {
+      uchar *row = image->scanLine(y);
+      switch (depth) {
+        case 8:
+          std::reverse(row, row + w);
+          break;
+        case 16:
+          std::reverse(reinterpret_cast<quint16 *>(row),
+                       reinterpret_cast<quint16 *>(row) + w);
+          break;
+        default:
+          ReverseRow32(reinterpret_cast<quint32 *>(row), w);
+          break;
+      }
+    }
+  }
+}
+
+void ShiftInPlace(QImage *image, int dx, int dy) {
+  if (image->isNull()) {
+    return;
+  }
+  const int w = image->width();
+  const int h = image->height();
+  dx = WrapShift(dx, w);
+  dy = WrapShift(dy, h);
+  if (dx == 0 && dy == 0) {
+    return;
+  }
+
+  const int depth = image->depth();
+  const int bpl = image->bytesPerLine();
+  // Never more than one row is parked.
+  QVarLengthArray<uchar, 1024> scratch(bpl);
+  if (dx != 0) {
+    if (depth % 8 != 0) {
+      // Sub byte pixels, only found in indexed images.
+      QImage row(scratch.data(), w, 1, bpl, image->format());
+      for (int y = 0; y < h; ++y) {
+        memcpy(scratch.data(), image->constScanLine(y), bpl);
+        for (int x = 0; x < w; ++x) {
+          image->setPixel((x + dx + w) % w, y, row.pixelIndex(x, 0));
+        }
+      }
+    } else {
+      const int pixel_bytes = depth / 8;
+      for (int y = 0; y < h; ++y) {
+        RotateBlocks(image->scanLine(y), w, pixel_bytes, dx, scratch.data());
+      }
+    }
+  }
+  if (dy != 0) {
+    RotateRows(image, dy, scratch.data());
+  }
+}
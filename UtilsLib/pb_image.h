@@ -0,0 +1,16 @@
+#ifndef PB_IMAGE_H
+#define PB_IMAGE_H
+#include <QImage>
+
+// Rotates |image| a quarter turn clockwise (or counter clockwise) into a
+// new image of transposed size. The format and color table are kept.
+QImage RotateQuarter(const QImage &image, bool cw);
+
+// Mirrors |image| without allocating a new one. Flipping again undoes it.
+void FlipInPlace(QImage *image, bool horizontal, bool vertical);
+
+// Moves the pixels of |image| by |dx|, |dy| in place, what falls off one
+// edge comes back on the opposite one. At most one row is held aside at a time.
+void ShiftInPlace(QImage *image, int dx, int dy);
+
+#endif // PB_IMAGE_H
@@ -8,6 +8,17 @@ T clamp(const T &v, const T &lower, const T &upper) {
   return (std::max)(lower, (std::min)(upper, v));
 }
 
+// |t| is clamped to [0, 1].
 QColor ColorLerp(QColor &c1, QColor &c2, float t);
 
+// Fixed point lerp of packed colors, |t| out of 256: 0 gives |a|, 256 gives
+// |b|. Channels are independent, so straight colors give straight results
+// and premultiplied ones stay premultiplied.
+QRgb RgbLerp(QRgb a, QRgb b, int t);
+
+// Writes |n| colors evenly spaced from |a| to |b| into |out|, both ends
+// included. Same rounding as RgbLerp, four colors at a time where SSE2 is
+// available.
+void GradientRamp(QRgb a, QRgb b, int n, QRgb *out);
+
 #endif // PB_MATH_H
@@ -0,0 +1,494 @@
+#include "pb_quantize.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+
+#include "pb_math.h"
+
+namespace {
+
+// Bands smaller than this are not worth a thread.
+const int kMinBandHeight = 16;
+
+// Past this many unique colors the histogram is folded into 5 bit cells, so
+// the box splits and k-means passes stay cheap on photos.
+const int kMaxWorkingColors = 1 << 15;
+// A band whose table grows past this counts straight into the cells.
+const int kMaxBandColors = 1 << 17;
+
+// Octree leaves sit at this depth, 6 bits per channel.
+const int kOctreeDepth = 6;
+
+// K-means points per task.
+const int kKMeansChunk = 4096;
+
+// A unique color (alpha dropped) and the pixels that have it.
+struct Entry {
+  QRgb color;
+  quint32 count;
+};
+
+// Unique colors with their counts, open addressing with linear probing.
+// Keys always carry an opaque alpha, so 0 marks an empty slot.
+class ColorHash {
+public:
+  ColorHash() : size_(0), mask_(0) { Rehash(1 << 10); }
+
+  int size() const { return size_; }
+
+  void Add(QRgb key, quint32 count) {
+    int i = Hash(key) & mask_;
+    while (keys_[i] != 0 && keys_[i] != key) {
+      i = (i + 1) & mask_;
+    }
+    if (keys_[i] == key) {
+      counts_[i] += count;
+      return;
+    }
+    keys_[i] = key;
+    counts_[i] = count;
+    if (++size_ * 2 > mask_) {
+      Rehash((mask_ + 1) * 2);
+    }
+  }
+
+  void AddAll(const ColorHash &other) {
+    for (int i = 0; i <= other.mask_; i++) {
+      if (other.keys_[i] != 0) {
+        Add(other.keys_[i], other.counts_[i]);
+      }
+    }
+  }
+
+  QVector<Entry> Entries() const {
+    QVector<Entry> entries;
+    entries.reserve(size_);
+    for (int i = 0; i <= mask_; i++) {
+      if (keys_[i] != 0) {
+        Entry e = {keys_[i], counts_[i]};
+        entries.push_back(e);
+      }
+    }
+    return entries;
+  }
+
+private:
+  QVector<quint32> keys_;
+  QVector<quint32> counts_;
+  int size_;
+  int mask_;
+
+  static quint32 Hash(quint32 key) { return (key * 0x9e3779b1u) >> 8; }
+
+  void Rehash(int capacity) {
+    QVector<quint32> keys = keys_;
+    QVector<quint32> counts = counts_;
+    keys_.fill(0, capacity);
+    counts_.fill(0, capacity);
+    mask_ = capacity - 1;
+    size_ = 0;
+    for (int i = 0; i < keys.size(); i++) {
+      if (keys[i] != 0) {
+        Add(keys[i], counts[i]);
+      }
+    }
+  }
+};
+
+inline int Channel(QRgb c, int channel) {
+  return (c >> (16 - 8 * channel)) & 0xff;
+}
+
+// Weighted color sums, the mean is the color a group stands for.
+struct Sum {
+  quint64 r;
+  quint64 g;
+  quint64 b;
+  quint64 count;
+
+  void Add(QRgb c, quint64 n) {
+    r += qRed(c) * n;
+    g += qGreen(c) * n;
+    b += qBlue(c) * n;
+    count += n;
+  }
+
+  void Add(const Sum &s) {
+    r += s.r;
+    g += s.g;
+    b += s.b;
+    count += s.count;
+  }
+
+  QRgb Mean() const {
+    quint64 h = count / 2;
+    return qRgb(int((r + h) / count), int((g + h) / count), int((b + h) / count));
+  }
+};
+
+// Rows [top, bottom) count into their own table, or into 5 bit cells once
+// the table holds too many colors.
+struct Band {
+  int top;
+  int bottom;
+  ColorHash hash;
+  QVector<Sum> cells;
+};
+
+inline int Cell(QRgb c) {
+  return ((qRed(c) >> 3) << 10) | ((qGreen(c) >> 3) << 5) | (qBlue(c) >> 3);
+}
+
+void AddToCells(const QVector<Entry> &entries, QVector<Sum> *cells) {
+  if (cells->isEmpty()) {
+    cells->fill(Sum{0, 0, 0, 0}, 1 << 15);
+  }
+  for (const Entry &e : entries) {
+    (*cells)[Cell(e.color)].Add(e.color, e.count);
+  }
+}
+
+// One entry per used cell, at the mean color of the cell.
+QVector<Entry> CellEntries(const QVector<Sum> &cells) {
+  QVector<Entry> entries;
+  for (const Sum &s : cells) {
+    if (s.count > 0) {
+      Entry e = {s.Mean(), quint32(qMin<quint64>(s.count, 0xffffffffu))};
+      entries.push_back(e);
+    }
+  }
+  return entries;
+}
+
+inline void Count(Band *band, QRgb c, quint32 n) {
+  if (!band->cells.isEmpty()) {
+    band->cells[Cell(c)].Add(c, n);
+    return;
+  }
+  band->hash.Add(c, n);
+  if (band->hash.size() > kMaxBandColors) {
+    AddToCells(band->hash.Entries(), &band->cells);
+    band->hash = ColorHash();
+  }
+}
+
+// Counts the colors of rows [top, bottom) of a 32 bit image. Runs of one
+// color, common in pixel art, hash once.
+void CountBand(const QImage &image, Band *band) {
+  bool premultiplied = image.format() == QImage::Format_ARGB32_Premultiplied;
+  bool opaque = image.format() == QImage::Format_RGB32;
+  QRgb run = 0;
+  quint32 run_length = 0;
+  for (int y = band->top; y < band->bottom; y++) {
+    const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+    for (int x = 0; x < image.width(); x++) {
+      QRgb c = line[x];
+      if (!opaque) {
+        int alpha = qAlpha(c);
+        if (alpha == 0) {
+          continue;
+        }
+        if (premultiplied && alpha != 0xff) {
+          c = qUnpremultiply(c);
+        }
+      }
+      c |= 0xff000000;
+      if (c == run) {
+        run_length++;
+        continue;
+      }
+      if (run_length > 0) {
+        Count(band, run, run_length);
+      }
+      run = c;
+      run_length = 1;
+    }
+  }
+  if (run_length > 0) {
+    Count(band, run, run_length);
+  }
+}
+
+QVector<Entry> Histogram(const QImage &image) {
+  int height = image.height();
+  int bands = qMax(1, qMin(QThreadPool::globalInstance()->maxThreadCount(), height / kMinBandHeight));
+  QVector<Band> band_list;
+  for (int i = 0; i < bands; i++) {
+    Band band = {height * i / bands, height * (i + 1) / bands, ColorHash(), QVector<Sum>()};
+    band_list.push_back(band);
+  }
+  QtConcurrent::blockingMap(band_list, [&image](Band &band) { CountBand(image, &band); });
+
+  bool coarse = false;
+  for (const Band &band : band_list) {
+    coarse = coarse || !band.cells.isEmpty();
+  }
+  if (!coarse) {
+    for (int i = 1; i < bands; i++) {
+      band_list[0].hash.AddAll(band_list[i].hash);
+    }
+    QVector<Entry> entries = band_list[0].hash.Entries();
+    if (entries.size() > kMaxWorkingColors) {
+      QVector<Sum> cells;
+      AddToCells(entries, &cells);
+      return CellEntries(cells);
+    }
+    return entries;
+  }
+  QVector<Sum> cells;
+  for (const Band &band : band_list) {
+    if (band.cells.isEmpty()) {
+      AddToCells(band.hash.Entries(), &cells);
+    } else if (cells.isEmpty()) {
+      cells = band.cells;
+    } else {
+      for (int i = 0; i < cells.size(); i++) {
+        cells[i].Add(band.cells[i]);
+      }
+    }
+  }
+  return CellEntries(cells);
+}
+
+struct Box {
+  int begin;
+  int end;
+  int channel;
+  int range;
+};
+
+Box MakeBox(const QVector<Entry> &entries, int begin, int end) {
+  int low[3] = {255, 255, 255};
+  int high[3] = {0, 0, 0};
+  for (int i = begin; i < end; i++) {
+    for (int c = 0; c < 3; c++) {
+      int v = Channel(entries[i].color, c);
+      low[c] = qMin(low[c], v);
+      high[c] = qMax(high[c], v);
+    }
+  }
+  Box box = {begin, end, 0, -1};
+  for (int c = 0; c < 3; c++) {
+    if (high[c] - low[c] > box.range) {
+      box.channel = c;
+      box.range = high[c] - low[c];
+    }
+  }
+  return box;
+}
+
+// Splits the box with the widest channel at its pixel median until there
+// are |colors| boxes or none can be split.
+QVector<QRgb> MedianCut(QVector<Entry> entries, int colors) {
+  QVector<Box> boxes;
+  boxes.push_back(MakeBox(entries, 0, entries.size()));
+  while (boxes.size() < colors) {
+    int widest = 0;
+    for (int i = 1; i < boxes.size(); i++) {
+      if (boxes[i].range > boxes[widest].range) {
+        widest = i;
+      }
+    }
+    Box box = boxes[widest];
+    if (box.range <= 0) {
+      break;
+    }
+    int channel = box.channel;
+    std::sort(entries.begin() + box.begin, entries.begin() + box.end,
+              [channel](const Entry &a, const Entry &b) {
+                return Channel(a.color, channel) < Channel(b.color, channel);
+              });
+    quint64 total = 0;
+    for (int i = box.begin; i < box.end; i++) {
+      total += entries[i].count;
+    }
+    int split = box.begin + 1;
+    quint64 below = entries[box.begin].count;
+    while (split < box.end - 1 && below * 2 < total) {
+      below += entries[split].count;
+      split++;
+    }
+    boxes[widest] = MakeBox(entries, box.begin, split);
+    boxes.push_back(MakeBox(entries, split, box.end));
+  }
+
+  QVector<QRgb> palette;
+  for (const Box &box : boxes) {
+    Sum sum = {0, 0, 0, 0};
+    for (int i = box.begin; i < box.end; i++) {
+      sum.Add(entries[i].color, entries[i].count);
+    }
+    palette.push_back(sum.Mean());
+  }
+  return palette;
+}
+
+struct OctreeNode {
+  Sum sum;
+  int children[8];
+  bool leaf;
+};
+
+// Classic octree reduction: every color is inserted down to kOctreeDepth,
+// then the lightest nodes of the deepest level are folded into leaves until
+// at most |colors| remain.
+QVector<QRgb> Octree(const QVector<Entry> &entries, int colors) {
+  QVector<OctreeNode> nodes;
+  QVector<QVector<int> > levels(kOctreeDepth);
+  OctreeNode root = {{0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}, false};
+  nodes.push_back(root);
+  levels[0].push_back(0);
+  int leaves = 0;
+  for (const Entry &e : entries) {
+    int node = 0;
+    nodes[node].sum.Add(e.color, e.count);
+    for (int level = 0; level < kOctreeDepth; level++) {
+      int shift = 7 - level;
+      int octant = (((qRed(e.color) >> shift) & 1) << 2) |
+                   (((qGreen(e.color) >> shift) & 1) << 1) | ((qBlue(e.color) >> shift) & 1);
+      int child = nodes[node].children[octant];
+      if (child == 0) {
+        child = nodes.size();
+        OctreeNode n = {{0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}, level + 1 == kOctreeDepth};
+        nodes.push_back(n);
+        nodes[node].children[octant] = child;
+        if (n.leaf) {
+          leaves++;
+        } else {
+          levels[level + 1].push_back(child);
+        }
+      }
+      node = child;
+      nodes[node].sum.Add(e.color, e.count);
+    }
+  }
+
+  for (int level = kOctreeDepth - 1; level >= 0 && leaves > colors; level--) {
+    QVector<int> &reducible = levels[level];
+    std::sort(reducible.begin(), reducible.end(),
+              [&nodes](int a, int b) { return nodes[a].sum.count < nodes[b].sum.count; });
+    for (int i = 0; i < reducible.size() && leaves > colors; i++) {
+      OctreeNode &node = nodes[reducible[i]];
+      int children = 0;
+      for (int c = 0; c < 8; c++) {
+        if (node.children[c] != 0) {
+          children++;
+          node.children[c] = 0;
+        }
+      }
+      node.leaf = true;
+      leaves -= children - 1;
+    }
+  }
+
+  QVector<QRgb> palette;
+  QVector<int> stack;
+  stack.push_back(0);
+  while (!stack.isEmpty()) {
+    const OctreeNode &node = nodes[stack.takeLast()];
+    if (node.leaf) {
+      palette.push_back(node.sum.Mean());
+      continue;
+    }
+    for (int c = 0; c < 8; c++) {
+      if (node.children[c] != 0) {
+        stack.push_back(node.children[c]);
+      }
+    }
+  }
+  return palette;
+}
+
+int Nearest(const QVector<QRgb> &palette, QRgb c) {
+  int best = 0;
+  int best_distance = INT_MAX;
+  for (int i = 0; i < palette.size(); i++) {
+    int dr = qRed(palette[i]) - qRed(c);
+    int dg = qGreen(palette[i]) - qGreen(c);
+    int db = qBlue(palette[i]) - qBlue(c);
+    int distance = dr * dr + dg * dg + db * db;
+    if (distance < best_distance) {
+      best = i;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+struct Chunk {
+  int begin;
+  int end;
+  QVector<Sum> sums;
+};
+
+// Lloyd iterations over the histogram: each color goes to its nearest
+// palette entry, which moves to the mean of its colors. Entries left
+// without colors stay put.
+void KMeans(const QVector<Entry> &entries, QVector<QRgb> *palette, int passes) {
+  QVector<Chunk> chunks;
+  for (int begin = 0; begin < entries.size(); begin += kKMeansChunk) {
+    Chunk chunk = {begin, qMin(begin + kKMeansChunk, entries.size()), QVector<Sum>()};
+    chunks.push_back(chunk);
+  }
+  for (int pass = 0; pass < passes; pass++) {
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+      chunk.sums.fill(Sum{0, 0, 0, 0}, palette->size());
+      for (int i = chunk.begin; i < chunk.end; i++) {
+        chunk.sums[Nearest(*palette, entries[i].color)].Add(entries[i].color, entries[i].count);
+      }
+    });
+    bool moved = false;
+    for (int i = 0; i < palette->size(); i++) {
+      Sum sum = {0, 0, 0, 0};
+      for (const Chunk &chunk : chunks) {
+        sum.Add(chunk.sums[i]);
+      }
+      if (sum.count > 0 && sum.Mean() != (*palette)[i]) {
+        (*palette)[i] = sum.Mean();
+        moved = true;
+      }
+    }
+    if (!moved) {
+      break;
+    }
+  }
+}
+
+QVector<QRgb> Sorted(QVector<QRgb> palette) {
+  std::sort(palette.begin(), palette.end(), [](QRgb a, QRgb b) {
+    int ga = qGray(a);
+    int gb = qGray(b);
+    return ga != gb ? ga < gb : a < b;
+  });
+  palette.erase(std::unique(palette.begin(), palette.end()), palette.end());
+  return palette;
+}
+
+}  // namespace
+
+QVector<QRgb> QuantizePalette(const QImage &image, int colors, QUANTIZER_ENUM quantizer, int kmeans_passes) {
+  if (image.isNull()) {
+    return QVector<QRgb>();
+  }
+  colors = clamp(colors, 2, 256);
+
+  QImage source = image;
+  if (source.format() != QImage::Format_ARGB32 && source.format() != QImage::Format_RGB32 &&
+      source.format() != QImage::Format_ARGB32_Premultiplied) {
+    source = source.convertToFormat(QImage::Format_ARGB32);
+  }
+  QVector<Entry> entries = Histogram(source);
+  if (entries.size() <= colors) {
+    QVector<QRgb> palette;
+    for (const Entry &e : entries) {
+      palette.push_back(e.color);
+    }
+    return Sorted(palette);
+  }
+
+  QVector<QRgb> palette = quantizer == QUANTIZER_OCTREE ? Octree(entries, colors) : MedianCut(entries, colors);
+  KMeans(entries, &palette, kmeans_passes);
+  return Sorted(palette);
+}
@@ -0,0 +1,19 @@
+#ifndef PB_QUANTIZE_H
+#define PB_QUANTIZE_H
+#include <QImage>
+#include <QVector>
+
+enum QUANTIZER_ENUM : int {
+  QUANTIZER_MEDIAN_CUT = 0,
+  QUANTIZER_OCTREE = 1
+};
+
+// Reduces the colors of |image| to a palette of at most |colors| (2 to 256),
+// sorted dark to light. Alpha is ignored and fully transparent pixels skipped.
+// The histogram is counted in bands on the global thread pool, each into its
+// own open addressing table of unique colors. Images with few enough colors
+// get them back exactly. |kmeans_passes| rounds of k-means refine the
+// palette over the histogram, 0 keeps the median cut or octree result.
+QVector<QRgb> QuantizePalette(const QImage &image, int colors, QUANTIZER_ENUM quantizer, int kmeans_passes = 4);
+
+#endif // PB_QUANTIZE_H
@@ -0,0 +1,536 @@
+#include "pb_scale.h"
+
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+
+#include "pb_image.h"
+#include "pb_math.h"
+
+namespace {
+
+// Bands smaller than this are not worth a thread.
+const int kMinBandHeight = 16;
+
+// hqx similarity thresholds, in YUV.
+const int kThresholdY = 48;
+const int kThresholdU = 7;
+const int kThresholdV = 6;
+const int kThresholdAlpha = 32;
+
+// RotSprite rotates an 8x upscale, each output pixel covers 8x8 samples.
+const int kRotSpriteScale = 8;
+// Output tiles upscale their part of the source on their own.
+const int kRotSpriteTile = 32;
+// Source pixels around a tile that still reach it through three Scale2x.
+const int kRotSpriteMargin = 3;
+
+struct Band {
+  int top;
+  int bottom;
+};
+
+// Maps output points back to the source.
+struct Rotation {
+  double cosine;
+  double sine;
+  QPointF source_center;
+  QPointF out_center;
+
+  QPointF Map(double x, double y) const {
+    double u = x - out_center.x();
+    double v = y - out_center.y();
+    return QPointF(cosine * u + sine * v + source_center.x(),
+                   -sine * u + cosine * v + source_center.y());
+  }
+};
+
+struct Yuv {
+  int y;
+  int u;
+  int v;
+  int a;
+};
+
+// Read only view of a 32 bit image, clamped at the borders.
+class Source {
+public:
+  explicit Source(const QImage &image)
+      : bits_(image.constBits()),
+        bytes_per_line_(image.bytesPerLine()),
+        width_(image.width()),
+        height_(image.height()) {}
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+  quint32 at(int x, int y) const {
+    x = clamp(x, 0, width_ - 1);
+    y = clamp(y, 0, height_ - 1);
+    return reinterpret_cast<const quint32 *>(bits_ + y * bytes_per_line_)[x];
+  }
+
+private:
+  const uchar *bits_;
+  int bytes_per_line_;
+  int width_;
+  int height_;
+};
+
+// Writable view of the destination, bands write to disjoint rows.
+class Destination {
+public:
+  explicit Destination(QImage *image)
+      : bits_(image->bits()), bytes_per_line_(image->bytesPerLine()) {}
+
+  quint32 *row(int y) const {
+    return reinterpret_cast<quint32 *>(bits_ + y * bytes_per_line_);
+  }
+
+private:
+  uchar *bits_;
+  int bytes_per_line_;
+};
+
+Yuv ToYuv(quint32 c) {
+  int r = qRed(c);
+  int g = qGreen(c);
+  int b = qBlue(c);
+  Yuv yuv;
+  yuv.y = (299 * r + 587 * g + 114 * b) / 1000;
+  yuv.u = (-169 * r - 331 * g + 500 * b) / 1000;
+  yuv.v = (500 * r - 419 * g - 81 * b) / 1000;
+  yuv.a = qAlpha(c);
+  return yuv;
+}
+
+bool Similar(quint32 a, quint32 b) {
+  if (a == b) {
+    return true;
+  }
+  Yuv ya = ToYuv(a);
+  Yuv yb = ToYuv(b);
+  return qAbs(ya.y - yb.y) <= kThresholdY && qAbs(ya.u - yb.u) <= kThresholdU &&
+         qAbs(ya.v - yb.v) <= kThresholdV && qAbs(ya.a - yb.a) <= kThresholdAlpha;
+}
+
+int Distance(quint32 a, quint32 b) {
+  if (a == b) {
+    return 0;
+  }
+  Yuv ya = ToYuv(a);
+  Yuv yb = ToYuv(b);
+  return 48 * qAbs(ya.y - yb.y) + 7 * qAbs(ya.u - yb.u) +
+         6 * qAbs(ya.v - yb.v) + 48 * qAbs(ya.a - yb.a);
+}
+
+// Blends premultiplied |a| towards |b| by |w|/256, two channels at a time.
+inline quint32 Lerp(quint32 a, quint32 b, int w) {
+  quint32 rb = ((a & 0xff00ff) * (256 - w) + (b & 0xff00ff) * w) >> 8;
+  quint32 ag = ((a >> 8) & 0xff00ff) * (256 - w) + ((b >> 8) & 0xff00ff) * w;
+  return (rb & 0xff00ff) | (ag & 0xff00ff00);
+}
+
+// Runs |process| over bands of source rows on the global thread pool, one
+// band per pool thread.
+template <typename F>
+void ForEachBand(int height, F process) {
+  int bands = qMax(1, qMin(QThreadPool::globalInstance()->maxThreadCount(), height / kMinBandHeight));
+  QVector<Band> band_list;
+  for (int i = 0; i < bands; i++) {
+    Band band = {height * i / bands, height * (i + 1) / bands};
+    band_list.push_back(band);
+  }
+  QtConcurrent::blockingMap(band_list, [&process](Band &band) { process(band.top, band.bottom); });
+}
+
+void Nearest(const Source &src, const Destination &dst, int n, int top, int bottom) {
+  for (int y = top; y < bottom; y++) {
+    quint32 *first = dst.row(y * n);
+    for (int x = 0; x < src.width(); x++) {
+      quint32 c = src.at(x, y);
+      for (int j = 0; j < n; j++) {
+        first[x * n + j] = c;
+      }
+    }
+    for (int i = 1; i < n; i++) {
+      memcpy(dst.row(y * n + i), first, src.width() * n * sizeof(quint32));
+    }
+  }
+}
+
+void Scale2x(const Source &src, const Destination &dst, int top, int bottom) {
+  for (int y = top; y < bottom; y++) {
+    quint32 *out0 = dst.row(y * 2);
+    quint32 *out1 = dst.row(y * 2 + 1);
+    for (int x = 0; x < src.width(); x++) {
+      quint32 b = src.at(x, y - 1);
+      quint32 d = src.at(x - 1, y);
+      quint32 e = src.at(x, y);
+      quint32 f = src.at(x + 1, y);
+      quint32 h = src.at(x, y + 1);
+      quint32 e0 = e, e1 = e, e2 = e, e3 = e;
+      if (b != h && d != f) {
+        e0 = d == b ? d : e;
+        e1 = b == f ? f : e;
+        e2 = d == h ? d : e;
+        e3 = h == f ? f : e;
+      }
+      out0[x * 2] = e0;
+      out0[x * 2 + 1] = e1;
+      out1[x * 2] = e2;
+      out1[x * 2 + 1] = e3;
+    }
+  }
+}
+
+void Scale3x(const Source &src, const Destination &dst, int top, int bottom) {
+  for (int y = top; y < bottom; y++) {
+    quint32 *out0 = dst.row(y * 3);
+    quint32 *out1 = dst.row(y * 3 + 1);
+    quint32 *out2 = dst.row(y * 3 + 2);
+    for (int x = 0; x < src.width(); x++) {
+      quint32 a = src.at(x - 1, y - 1), b = src.at(x, y - 1), c = src.at(x + 1, y - 1);
+      quint32 d = src.at(x - 1, y), e = src.at(x, y), f = src.at(x + 1, y);
+      quint32 g = src.at(x - 1, y + 1), h = src.at(x, y + 1), i = src.at(x + 1, y + 1);
+      quint32 o[9] = {e, e, e, e, e, e, e, e, e};
+      if (b != h && d != f) {
+        o[0] = d == b ? d : e;
+        o[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+        o[2] = b == f ? f : e;
+        o[3] = (d == b && e != g) || (d == h && e != a) ? d : e;
+        o[5] = (b == f && e != i) || (h == f && e != c) ? f : e;
+        o[6] = d == h ? d : e;
+        o[7] = (d == h && e != i) || (h == f && e != g) ? h : e;
+        o[8] = h == f ? f : e;
+      }
+      for (int j = 0; j < 3; j++) {
+        out0[x * 3 + j] = o[j];
+        out1[x * 3 + j] = o[3 + j];
+        out2[x * 3 + j] = o[6 + j];
+      }
+    }
+  }
+}
+
+// hqx and xBR both decide, for each corner of a source pixel, a color the
+// corner is pulled towards and how strongly. The subpixels of the corner's
+// quadrant then blend by their distance from the pixel center.
+struct CornerRule {
+  quint32 target;
+  int strength;  // Out of 256, at the subpixel of a 2x scale.
+};
+
+enum HQX_TARGET { HQX_SELF, HQX_DIAGONAL, HQX_EDGE_1, HQX_EDGE_2, HQX_EDGES };
+
+struct HqxRule {
+  HQX_TARGET target;
+  int strength;
+};
+
+// Condensed hqx table. Indexed by which of the two edge neighbours and the
+// diagonal neighbour of a corner differ from the center, and whether the
+// two edge neighbours match each other:
+//   bit 0 edge 1 differs, bit 1 edge 2 differs, bit 2 diagonal differs,
+//   bit 3 edge neighbours are similar.
+const HqxRule kHqxTable[16] = {
+    {HQX_SELF, 0},        // Flat.
+    {HQX_EDGE_1, 64},     // Edge 1 only, a straight border.
+    {HQX_EDGE_2, 64},     // Edge 2 only.
+    {HQX_EDGES, 96},      // Both edges, different colors.
+    {HQX_DIAGONAL, 64},   // Diagonal only.
+    {HQX_EDGE_1, 64},     // Edge 1 and diagonal.
+    {HQX_EDGE_2, 64},     // Edge 2 and diagonal.
+    {HQX_EDGES, 96},      // Everything differs, no shared color.
+    {HQX_SELF, 0},        // Flat, edges similar to each other too.
+    {HQX_EDGE_1, 64},
+    {HQX_EDGE_2, 64},
+    {HQX_EDGES, 128},     // A thin diagonal line passing the corner.
+    {HQX_DIAGONAL, 64},
+    {HQX_EDGE_1, 64},
+    {HQX_EDGE_2, 64},
+    {HQX_EDGES, 192},     // A corner sticking out, cut along the diagonal.
+};
+
+CornerRule HqxCorner(const Source &src, int x, int y, int sx, int sy) {
+  quint32 e = src.at(x, y);
+  quint32 e1 = src.at(x + sx, y);
+  quint32 e2 = src.at(x, y + sy);
+  quint32 d = src.at(x + sx, y + sy);
+  int pattern = (Similar(e, e1) ? 0 : 1) | (Similar(e, e2) ? 0 : 2) |
+                (Similar(e, d) ? 0 : 4) | (Similar(e1, e2) ? 8 : 0);
+  const HqxRule &rule = kHqxTable[pattern];
+  CornerRule corner = {e, rule.strength};
+  switch (rule.target) {
+    case HQX_DIAGONAL:
+      corner.target = d;
+      break;
+    case HQX_EDGE_1:
+      corner.target = e1;
+      break;
+    case HQX_EDGE_2:
+      corner.target = e2;
+      break;
+    case HQX_EDGES:
+      corner.target = Lerp(e1, e2, 128);
+      break;
+    default:
+      break;
+  }
+  return corner;
+}
+
+// xBR level 1, written for the bottom right corner and mirrored by |sx|, |sy|.
+CornerRule XbrCorner(const Source &src, int x, int y, int sx, int sy) {
+  auto p = [&src, x, y, sx, sy](int dx, int dy) { return src.at(x + dx * sx, y + dy * sy); };
+  quint32 b = p(0, -1), c = p(1, -1);
+  quint32 d = p(-1, 0), e = p(0, 0), f = p(1, 0), f4 = p(2, 0);
+  quint32 g = p(-1, 1), h = p(0, 1), i = p(1, 1), i4 = p(2, 1);
+  quint32 h5 = p(0, 2), i5 = p(1, 2);
+
+  CornerRule corner = {e, 0};
+  if (e == f || e == h) {
+    return corner;
+  }
+  int across = Distance(e, c) + Distance(e, g) + Distance(i, f4) + Distance(i, h5) + 4 * Distance(h, f);
+  int along = Distance(h, d) + Distance(h, i5) + Distance(f, i4) + Distance(f, b) + 4 * Distance(e, i);
+  if (across < along) {
+    corner.target = Distance(e, f) <= Distance(e, h) ? f : h;
+    corner.strength = 128;
+  }
+  return corner;
+}
+
+struct SubPixel {
+  int corner;  // 0 top left, 1 top right, 2 bottom left, 3 bottom right.
+  int weight;  // Out of 256, 256 for the subpixels of a 2x scale.
+};
+
+QVector<SubPixel> SubPixels(int n) {
+  QVector<SubPixel> table(n * n);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      SubPixel &s = table[i * n + j];
+      s.corner = (2 * i >= n ? 2 : 0) + (2 * j >= n ? 1 : 0);
+      // Distances from the center, in units of 1/(2n) of a source pixel.
+      int du = qAbs(2 * j + 1 - n);
+      int dv = qAbs(2 * i + 1 - n);
+      // The middle row and column of odd scales belong to no corner.
+      s.weight = (du == 0 || dv == 0) ? 0 : (du + dv) * 256 / n;
+    }
+  }
+  return table;
+}
+
+template <typename Rule>
+void CornerScale(const Source &src, const Destination &dst, int n,
+                 const QVector<SubPixel> &sub_pixels, Rule rule, int top, int bottom) {
+  static const int kSigns[4][2] = {{-1, -1}, {1, -1}, {-1, 1}, {1, 1}};
+  CornerRule corners[4];
+  for (int y = top; y < bottom; y++) {
+    for (int x = 0; x < src.width(); x++) {
+      quint32 e = src.at(x, y);
+      for (int k = 0; k < 4; k++) {
+        corners[k] = rule(src, x, y, kSigns[k][0], kSigns[k][1]);
+      }
+      for (int i = 0; i < n; i++) {
+        quint32 *out = dst.row(y * n + i) + x * n;
+        for (int j = 0; j < n; j++) {
+          const SubPixel &s = sub_pixels[i * n + j];
+          const CornerRule &c = corners[s.corner];
+          out[j] = Lerp(e, c.target, qMin(256, c.strength * s.weight / 256));
+        }
+      }
+    }
+  }
+}
+
+QImage Upscale2x(const QImage &image) {
+  QImage out(image.size() * 2, QImage::Format_ARGB32_Premultiplied);
+  Scale2x(Source(image), Destination(&out), 0, image.height());
+  return out;
+}
+
+// Most common of |colors|, ties go to |preferred|. Sorts |colors|.
+quint32 Mode(quint32 *colors, int count, quint32 preferred) {
+  std::sort(colors, colors + count);
+  quint32 best = preferred;
+  int best_count = 0;
+  for (int i = 0; i < count;) {
+    int j = i + 1;
+    while (j < count && colors[j] == colors[i]) {
+      j++;
+    }
+    if (j - i > best_count || (j - i == best_count && colors[i] == preferred)) {
+      best = colors[i];
+      best_count = j - i;
+    }
+    i = j;
+  }
+  return best;
+}
+
+bool Inside(const QPointF &p, const QSize &size) {
+  return p.x() >= 0 && p.y() >= 0 && p.x() < size.width() && p.y() < size.height();
+}
+
+void RotateNearest(const Source &src, const Destination &dst, const Rotation &r, int width, int top, int bottom) {
+  QSize size(src.width(), src.height());
+  for (int y = top; y < bottom; y++) {
+    quint32 *out = dst.row(y);
+    for (int x = 0; x < width; x++) {
+      QPointF p = r.Map(x + 0.5, y + 0.5);
+      out[x] = Inside(p, size) ? src.at(int(p.x()), int(p.y())) : 0;
+    }
+  }
+}
+
+void RotSpriteTile(const QImage &image, const Destination &dst, const Rotation &r, const QRect &tile) {
+  QPointF corners[4] = {r.Map(tile.left(), tile.top()), r.Map(tile.right() + 1, tile.top()),
+                        r.Map(tile.left(), tile.bottom() + 1), r.Map(tile.right() + 1, tile.bottom() + 1)};
+  double left = corners[0].x(), right = left, top = corners[0].y(), bottom = top;
+  for (const QPointF &p : corners) {
+    left = qMin(left, p.x());
+    right = qMax(right, p.x());
+    top = qMin(top, p.y());
+    bottom = qMax(bottom, p.y());
+  }
+  QRect area(QPoint(int(std::floor(left)) - kRotSpriteMargin, int(std::floor(top)) - kRotSpriteMargin),
+             QPoint(int(std::ceil(right)) + kRotSpriteMargin, int(std::ceil(bottom)) + kRotSpriteMargin));
+  QRect reach = image.rect().adjusted(-kRotSpriteMargin, -kRotSpriteMargin, kRotSpriteMargin, kRotSpriteMargin);
+  area &= reach;
+  if (area.isEmpty()) {
+    for (int y = tile.top(); y <= tile.bottom(); y++) {
+      memset(dst.row(y) + tile.left(), 0, tile.width() * sizeof(quint32));
+    }
+    return;
+  }
+
+  // Pixels past the edges copy in transparent, the upscale blends into it.
+  const QImage up = Upscale2x(Upscale2x(Upscale2x(image.copy(area))));
+  const Source big(up);
+  const int n = kRotSpriteScale;
+  quint32 samples[kRotSpriteScale * kRotSpriteScale];
+  for (int y = tile.top(); y <= tile.bottom(); y++) {
+    quint32 *out = dst.row(y);
+    for (int x = tile.left(); x <= tile.right(); x++) {
+      for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+          QPointF p = r.Map(x + (j + 0.5) / n, y + (i + 0.5) / n);
+          samples[i * n + j] = Inside(p, image.size())
+                                   ? big.at(int((p.x() - area.left()) * n), int((p.y() - area.top()) * n))
+                                   : 0;
+        }
+      }
+      out[x] = Mode(samples, n * n, samples[(n / 2) * n + n / 2]);
+    }
+  }
+}
+
+QImage Run(const QImage &source, SCALER_ENUM scaler, int n) {
+  QImage out(source.size() * n, QImage::Format_ARGB32_Premultiplied);
+  const Source src(source);
+  const Destination dst(&out);
+  switch (scaler) {
+    case SCALER_SCALE_NX:
+      if (n == 3) {
+        ForEachBand(src.height(), [&](int top, int bottom) { Scale3x(src, dst, top, bottom); });
+      } else {
+        ForEachBand(src.height(), [&](int top, int bottom) { Scale2x(src, dst, top, bottom); });
+      }
+      break;
+    case SCALER_HQX: {
+      QVector<SubPixel> sub_pixels = SubPixels(n);
+      ForEachBand(src.height(), [&](int top, int bottom) {
+        CornerScale(src, dst, n, sub_pixels, HqxCorner, top, bottom);
+      });
+      break;
+    }
+    case SCALER_XBR: {
+      QVector<SubPixel> sub_pixels = SubPixels(n);
+      ForEachBand(src.height(), [&](int top, int bottom) {
+        CornerScale(src, dst, n, sub_pixels, XbrCorner, top, bottom);
+      });
+      break;
+    }
+    default:
+      ForEachBand(src.height(), [&](int top, int bottom) { Nearest(src, dst, n, top, bottom); });
+      break;
+  }
+  return out;
+}
+
+}  // namespace
+
+QImage ScalePixelArt(const QImage &image, SCALER_ENUM scaler, int factor) {
+  if (image.isNull() || factor < 1) {
+    return QImage();
+  }
+  if (scaler != SCALER_NEAREST) {
+    factor = clamp(factor, 2, 4);
+  }
+
+  QImage out = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  if (scaler == SCALER_SCALE_NX && factor == 4) {
+    out = Run(Run(out, scaler, 2), scaler, 2);
+  } else if (factor > 1) {
+    out = Run(out, scaler, factor);
+  }
+
+  if (image.format() == QImage::Format_Indexed8) {
+    return out.convertToFormat(QImage::Format_Indexed8, image.colorTable());
+  }
+  return out.convertToFormat(image.format());
+}
+
+QImage RotatePixelArt(const QImage &image, double degrees, bool preview) {
+  if (image.isNull()) {
+    return QImage();
+  }
+  double turns = degrees / 90;
+  if (turns == std::floor(turns)) {
+    switch (((int(turns) % 4) + 4) % 4) {
+      case 1:
+        return RotateQuarter(image, true);
+      case 2:
+        return RotateQuarter(RotateQuarter(image, true), true);
+      case 3:
+        return RotateQuarter(image, false);
+      default:
+        return image.copy();
+    }
+  }
+
+  Rotation r;
+  r.cosine = std::cos(qDegreesToRadians(degrees));
+  r.sine = std::sin(qDegreesToRadians(degrees));
+  double w = image.width() * qAbs(r.cosine) + image.height() * qAbs(r.sine);
+  double h = image.width() * qAbs(r.sine) + image.height() * qAbs(r.cosine);
+  QSize size(int(std::ceil(w - 1e-6)), int(std::ceil(h - 1e-6)));
+  r.source_center = QPointF(image.width() / 2.0, image.height() / 2.0);
+  r.out_center = QPointF(size.width() / 2.0, size.height() / 2.0);
+
+  const QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  QImage out(size, QImage::Format_ARGB32_Premultiplied);
+  const Destination dst(&out);
+  if (preview) {
+    const Source src(source);
+    ForEachBand(size.height(), [&](int top, int bottom) { RotateNearest(src, dst, r, size.width(), top, bottom); });
+  } else {
+    ForEachBand(size.height(), [&](int top, int bottom) {
+      for (int y = top; y < bottom; y += kRotSpriteTile) {
+        for (int x = 0; x < size.width(); x += kRotSpriteTile) {
+          RotSpriteTile(source, dst, r, QRect(x, y, qMin(kRotSpriteTile, size.width() - x), qMin(kRotSpriteTile, bottom - y)));
+        }
+      }
+    });
+  }
+
+  if (image.format() == QImage::Format_Indexed8) {
+    return out.convertToFormat(QImage::Format_Indexed8, image.colorTable());
+  }
+  return out.convertToFormat(image.format());
+}
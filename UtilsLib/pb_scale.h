@@ -0,0 +1,27 @@
+#ifndef PB_SCALE_H
+#define PB_SCALE_H
+#include <QImage>
+
+enum SCALER_ENUM : int {
+  SCALER_NEAREST = 0,
+  // EPX/Scale2x, Scale3x, and Scale4x as Scale2x twice.
+  SCALER_SCALE_NX = 1,
+  SCALER_HQX = 2,
+  SCALER_XBR = 3
+};
+
+// Scales |image| up by |factor| with a pixel art scaler. Nearest neighbour
+// takes any factor, the others 2 to 4. Rows are processed in bands on the
+// global thread pool. The format is kept, indexed images are mapped back to
+// their color table.
+QImage ScalePixelArt(const QImage &image, SCALER_ENUM scaler, int factor);
+
+// Rotates |image| clockwise by |degrees| with RotSprite: an 8x Scale2x
+// upscale rotated by nearest neighbour, each output pixel taking the most
+// common color under it. The result is sized to hold the whole rotated
+// image. Output tiles are upscaled one at a time, so memory stays bounded.
+// |preview| samples the source by nearest neighbour instead, fast enough to
+// follow a drag. Quarter turns are exact either way.
+QImage RotatePixelArt(const QImage &image, double degrees, bool preview = false);
+
+#endif // PB_SCALE_H
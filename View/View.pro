@@ -24,7 +24,7 @@ lessThan(QT_MINOR_VERSION,5){
   error(Must have at least Qt 5.5)
 }
 
-QT       += core gui widgets
+QT       += core gui widgets concurrent
 
 RC_ICONS = icon.ico
 
@@ -41,7 +41,12 @@ FORMS    += \
     screens/main_window.ui \
     widgets/color_dialog.ui \
     screens/resize_image_dialog.ui \
-    screens/help_dialog.ui
+    screens/help_dialog.ui \
+    screens/layer_properties_dialog.ui \
+    screens/quantize_dialog.ui \
+    screens/scale_selection_dialog.ui \
+    screens/shadow_dialog.ui \
+    screens/rotate_dialog.ui
 
 RESOURCES += \
     resources/icons/icons.qrc \
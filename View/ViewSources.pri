@@ -13,8 +13,24 @@ SOURCES += \
     screens/set_tile_size_dialog.cpp \
     screens/main_window.cpp \
     widgets/color_palette_widget.cpp \
+    widgets/navigator_widget.cpp \
+    widgets/animation_preview_widget.cpp \
+    widgets/voxel_preview_widget.cpp \
     logic/undo_redo.cpp \
     logic/tool_algorithm.cpp \
+    logic/mipmap_pyramid.cpp \
+    logic/tiled_image.cpp \
+    logic/indexed_color.cpp \
+    logic/layer_stack.cpp \
+    logic/bit_mask.cpp \
+    logic/floating_selection.cpp \
+    logic/image_mime_data.cpp \
+    logic/animation_timeline.cpp \
+    logic/voxel_volume.cpp \
+    logic/voxel_renderer.cpp \
+    logic/hibernation.cpp \
+    logic/shadow_effect.cpp \
+    logic/pixel_format.cpp \
     #utils/pb_math.cpp \
     widgets/color_dialog.cpp \
     logic/tool/pencil_tool.cpp \
@@ -25,7 +41,12 @@ SOURCES += \
     logic/tool/selection_tool.cpp \
     logic/tool/zoom_tool.cpp \
     screens/resize_image_dialog.cpp \
-    screens/help_dialog.cpp
+    screens/help_dialog.cpp \
+    screens/layer_properties_dialog.cpp \
+    screens/quantize_dialog.cpp \
+    screens/scale_selection_dialog.cpp \
+    screens/shadow_dialog.cpp \
+    screens/rotate_dialog.cpp
 
 HEADERS  += \
     widgets/image_edit_widget.h \
@@ -41,9 +62,25 @@ HEADERS  += \
     screens/set_tile_size_dialog.h \
     screens/main_window.h \
     widgets/color_palette_widget.h \
+    widgets/navigator_widget.h \
+    widgets/animation_preview_widget.h \
+    widgets/voxel_preview_widget.h \
     resources/version.h \
     logic/undo_redo.h \
     logic/tool_algorithm.h \
+    logic/mipmap_pyramid.h \
+    logic/tiled_image.h \
+    logic/indexed_color.h \
+    logic/layer_stack.h \
+    logic/bit_mask.h \
+    logic/floating_selection.h \
+    logic/image_mime_data.h \
+    logic/animation_timeline.h \
+    logic/voxel_volume.h \
+    logic/voxel_renderer.h \
+    logic/hibernation.h \
+    logic/shadow_effect.h \
+    logic/pixel_format.h \
     #utils/pb_math.h \
     widgets/color_dialog.h \
     logic/tool/pencil_tool.h \
@@ -54,4 +91,9 @@ HEADERS  += \
     logic/tool/selection_tool.h \
     logic/tool/zoom_tool.h \
     screens/resize_image_dialog.h \
-    screens/help_dialog.h
+    screens/help_dialog.h \
+    screens/layer_properties_dialog.h \
+    screens/quantize_dialog.h \
+    screens/scale_selection_dialog.h \
+    screens/shadow_dialog.h \
+    screens/rotate_dialog.h
@@ -20,6 +20,7 @@
 #include "global_options.h"
 
 #include <QSettings>
+#include <QtMath>
 
 #include "utils/debug.h"
 #include "pb_math.h"
@@ -92,12 +93,14 @@ void GlobalOptions::MoveSelection(const QPoint &center) {
   tile_selection_.moveCenter(center);
 }
 
-QRect GlobalOptions::PosToGrid(const QPoint &pos) const {
+QRect GlobalOptions::PosToGrid(const QPoint &pos, qreal zoom) const {
+  // pos is in widget space of a view showing the image at |zoom|.
+  QPoint image_pos = QPoint(qFloor(pos.x() / zoom), qFloor(pos.y() / zoom));
   int x = (horizontal_shift_ ? cursor_size_.width() / 2 : 0);
   int y = (vertical_shift_ ? cursor_size_.height() / 2 : 0);
   QPoint top_left = QPoint(
-      ((pos.x() + x) / cursor_size_.width()) * cursor_size_.width() - x,
-      ((pos.y() + y) / cursor_size_.height()) * cursor_size_.height() - y);
+      ((image_pos.x() + x) / cursor_size_.width()) * cursor_size_.width() - x,
+      ((image_pos.y() + y) / cursor_size_.height()) * cursor_size_.height() - y);
 
   return QRect(top_left, cursor_size_);
 }
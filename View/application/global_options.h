@@ -85,7 +85,7 @@ public:
   bool show_pixel_grid() const;
   void set_show_pixel_grid(bool show);
 
-  QRect PosToGrid(const QPoint &pos) const;
+  QRect PosToGrid(const QPoint &pos, qreal zoom = 1.0) const;
 
   void SaveState(QSettings *settings) const;
   void LoadState(QSettings *settings);
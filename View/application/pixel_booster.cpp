@@ -19,6 +19,7 @@
 
 #include "application/pixel_booster.h"
 
+#include <QStatusBar>
 #include <QTimer>
 #include <QTranslator>
 
@@ -29,10 +30,17 @@ const QString kApplicationName = "Pixel::Booster";
 const QString kOrganizationName = "Busta Software";
 const QString kOrganizationDomain = "pixel.busta.com.br";
 
+// Status bar messages are shown at most once per display frame.
+const int kStatusMessageInterval = 16;
+
 PixelBooster::PixelBooster(int argc, char *argv[])
     : QApplication(argc, argv),
       options_(new GlobalOptions()),
-      main_window_(new MainWindow()) {
+      main_window_(new MainWindow()),
+      status_timer_(new QTimer(this)) {
+  status_timer_->setSingleShot(true);
+  status_timer_->setInterval(kStatusMessageInterval);
+  QObject::connect(status_timer_, SIGNAL(timeout()), this, SLOT(FlushStatusMessage()));
   QCoreApplication::setApplicationName(kApplicationName);
   QCoreApplication::setOrganizationName(kOrganizationName);
   QCoreApplication::setOrganizationDomain(kOrganizationDomain);
@@ -47,6 +55,17 @@ GlobalOptions *PixelBooster::options() const {
   return options_;
 }
 
+void PixelBooster::SetStatusMessage(const QString &message) {
+  pending_status_message_ = message;
+  if (!status_timer_->isActive()) {
+    status_timer_->start();
+  }
+}
+
+void PixelBooster::FlushStatusMessage() {
+  main_window_->statusBar()->showMessage(pending_status_message_);
+}
+
 void PixelBooster::Translate(QString language) {
   QTranslator *translator = new QTranslator();
   translator->load(":/translations/pixel_booster_" + language);
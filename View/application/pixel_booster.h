@@ -27,11 +27,13 @@
 #define pApp dynamic_cast<PixelBooster *>(qApp)
 
 class MainWindow;
+class QTimer;
 
 /*!
  * \brief The PixelBooster class
  */
 class PixelBooster : public QApplication {
+  Q_OBJECT
 public:
   PixelBooster(int argc, char *argv[]);
 
@@ -45,6 +47,12 @@ public:
 private:
   GlobalOptions *options_;
   MainWindow *main_window_;
+
+  QString pending_status_message_;
+  QTimer *status_timer_;
+
+private slots:
+  void FlushStatusMessage();
 };
 
 #endif // PIXEL_BOOSTER_H
@@ -20,13 +20,19 @@
 #include "action_handler.h"
 
 #include "application/pixel_booster.h"
+#include "logic/indexed_color.h"
 #include "resources/version.h"
 #include "screens/about_dialog.h"
 #include "screens/help_dialog.h"
 #include "screens/main_window.h"
+#include "screens/layer_properties_dialog.h"
 #include "screens/new_image_file_dialog.h"
+#include "screens/quantize_dialog.h"
 #include "screens/resize_image_dialog.h"
+#include "screens/rotate_dialog.h"
+#include "screens/scale_selection_dialog.h"
 #include "screens/set_tile_size_dialog.h"
+#include "screens/shadow_dialog.h"
 #include "utils/debug.h"
 #include "pb_math.h"
 #include "widgets/color_dialog.h"
@@ -37,11 +43,11 @@
 
 #include <QAction>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QLabel>
 #include <QMdiArea>
 #include <QMdiSubWindow>
 #include <QMessageBox>
-#include <QPainter>
 #include <QSlider>
 
 const QString kTxtSelectMainColor = "Select Main Color";
@@ -51,6 +57,14 @@ const QString kColorButtonStyle = "background-color: %1; border: 1px solid black
 
 const QString kSavedPaletteLocation = "palette.png";
 
+const QSize kSparseWindowSize(640, 480);
+
+// Colors in each row of the gradient strip.
+const int kGradientSteps = 10;
+
+const int kDefaultVoxelModelSize = 32;
+const int kMaxVoxelModelSize = 256;
+
 ActionHandler::ActionHandler(QObject *parent)
     : QObject(parent),
       options_cache_(pApp->options()),
@@ -82,8 +96,28 @@ void ActionHandler::NewFile() const {
   QSize size = image_file_dialog->selected_size();
   QImage::Format format = image_file_dialog->selected_format();
 
+  if (image_file_dialog->selected_sparse()) {
+    // Nothing is allocated up front, tiles appear where the user draws.
+    // Sparse documents are always 32 bit and start transparent.
+    QImage placeholder(1, 1, QImage::Format_ARGB32_Premultiplied);
+    placeholder.fill(Qt::transparent);
+    ImageCanvasContainer *canvas_container = CreateImageCanvas(placeholder, "");
+    canvas_container->GetCanvasWidget()->SetSparseImage(size);
+    canvas_container->parentWidget()->resize(size.boundedTo(kSparseWindowSize) + QSize(50, 50));
+    delete image_file_dialog;
+    return;
+  }
+
   QImage image(size, format);
-  image.fill(image_file_dialog->selected_color());
+  if (format == QImage::Format_Indexed8) {
+    // The background takes index 0, the rest of the palette comes from the
+    // colors of the current user palette.
+    QVector<QRgb> table = {image_file_dialog->selected_color().rgba()};
+    image.setColorTable(IndexedColor::ColorTable(*window_cache_->color_palette()->palette(), table));
+    image.fill(0);
+  } else {
+    image.fill(image_file_dialog->selected_color());
+  }
   CreateImageCanvas(image, "");
 
   delete image_file_dialog;
@@ -95,20 +129,10 @@ void ActionHandler::OpenFile() const {
 
   for (QString file_name : file_names) {
     if (!file_name.isEmpty()) {
+      // 8 bit indexed images are edited as they are and saved back with
+      // their palette.
       QImage image(file_name);
       if (!image.isNull()) {
-        if (image.format() == QImage::Format_Indexed8) {
-          int ans = QMessageBox::question(window_cache_,
-                                          QString("Unable to open image file."),
-                                          QString("The file you tried to open is an 8 bit indexed image format and is not supported in the current version of the software. Do you want to convert it to another image format?"),
-                                          QMessageBox::Yes | QMessageBox::No,
-                                          QMessageBox::No);
-          if (ans == QMessageBox::Yes) {
-            image = image.convertToFormat(QImage::Format_ARGB32);
-          } else {
-            return;
-          }
-        }
         CreateImageCanvas(image, file_name);
       }
     }
@@ -166,10 +190,21 @@ bool ActionHandler::CloseWindowHandler() const {
 }
 
 void ActionHandler::Undo() const {
+  // Document wide steps are kept by the canvas, the newest step goes first.
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w && w->UndoTimestamp() > window_cache_->edit_widget()->UndoTimestamp()) {
+    w->Undo();
+    return;
+  }
   window_cache_->edit_widget()->Undo();
 }
 
 void ActionHandler::Redo() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w && w->RedoTimestamp() > window_cache_->edit_widget()->RedoTimestamp()) {
+    w->Redo();
+    return;
+  }
   window_cache_->edit_widget()->Redo();
 }
 
@@ -193,6 +228,24 @@ void ActionHandler::ArrowPressed(QAction *a) const {
     window_cache_->edit_widget()->Flip(true, false);
   } else if (tool == "actionFlip_Vertical") {
     window_cache_->edit_widget()->Flip(false, true);
+  } else if (tool == "actionShift_Left") {
+    window_cache_->edit_widget()->Shift(-1, 0);
+  } else if (tool == "actionShift_Right") {
+    window_cache_->edit_widget()->Shift(1, 0);
+  } else if (tool == "actionShift_Up") {
+    window_cache_->edit_widget()->Shift(0, -1);
+  } else if (tool == "actionShift_Down") {
+    window_cache_->edit_widget()->Shift(0, 1);
+  } else if (tool == "actionRotate") {
+    RotateDialog dialog(window_cache_->edit_widget()->selected_pixels(), window_cache_);
+    if (dialog.exec() == QDialog::Accepted) {
+      window_cache_->edit_widget()->RotateBy(dialog.degrees());
+    }
+  } else if (tool == "actionScale_Selection") {
+    ScaleSelectionDialog dialog(window_cache_);
+    if (dialog.exec() == QDialog::Accepted) {
+      window_cache_->edit_widget()->Scale(dialog.scaler(), dialog.factor());
+    }
   }
 }
 
@@ -268,19 +321,12 @@ void ActionHandler::SwapColors() const {
 }
 
 void ActionHandler::SetColorGradient() const {
-  QColor main = options_cache_->main_color();
-  QColor alt = options_cache_->alt_color();
-  QImage new_deg = QImage(10, 3, QImage::Format_ARGB32_Premultiplied);
-  QColor black = Qt::black;
-  QColor white = Qt::white;
-  for (int i = 0; i < 10; i++) {
-    float f = float(i) / 9.0f;
-    QColor c0 = ColorLerp(main, alt, f);
-    QColor c1 = ColorLerp(main, black, f);
-    QColor c2 = ColorLerp(main, white, f);
-    new_deg.setPixel(i, 0, c0.rgba());
-    new_deg.setPixel(i, 1, c1.rgba());
-    new_deg.setPixel(i, 2, c2.rgba());
+  // Premultiplied ramps, written straight into the rows.
+  QRgb main = qPremultiply(options_cache_->main_color().rgba());
+  QRgb ends[] = {qPremultiply(options_cache_->alt_color().rgba()), qRgb(0, 0, 0), qRgb(255, 255, 255)};
+  QImage new_deg = QImage(kGradientSteps, 3, QImage::Format_ARGB32_Premultiplied);
+  for (int row = 0; row < 3; row++) {
+    GradientRamp(main, ends[row], kGradientSteps, reinterpret_cast<QRgb *>(new_deg.scanLine(row)));
   }
   window_cache_->SetDegColor(new_deg);
 }
@@ -308,6 +354,24 @@ void ActionHandler::SavePalette() const {
   }
 }
 
+void ActionHandler::PaletteFromImage() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr == w) {
+    return;
+  }
+  QuantizeDialog dialog(window_cache_);
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+  QVector<QRgb> table = QuantizePalette(w->image(), dialog.colors(), dialog.quantizer(), dialog.kmeans_passes());
+  QImage image = IndexedColor::PaletteImage(table);
+  if (!image.isNull()) {
+    window_cache_->color_palette()->SetPalette(image);
+    window_cache_->color_palette()->repaint();
+    image.save(kSavedPaletteLocation);
+  }
+}
+
 void ActionHandler::DefaultPalette() const {
   QImage image = QImage(":/images/color_palette.png");
   window_cache_->color_palette()->SetPalette(image);
@@ -337,19 +401,121 @@ void ActionHandler::ImageSize() const {
   ImageCanvasContainer *c = window_cache_->current_canvas_container();
   if (c == nullptr)
     return;
-  QImage old_image = c->GetCanvasWidget()->image();
-  QSize size = old_image.size();
+  QSize size = c->GetCanvasWidget()->image_rect().size();
 
   ResizeImageDialog dialog(size, window_cache_);
   int res = dialog.exec();
 
   if (res == QDialog::Accepted) {
-    QSize new_size = dialog.new_size();
-    QImage new_image = QImage(new_size, QImage::Format_ARGB32);
-    new_image.fill(options_cache_->alt_color());
-    QPainter p(&new_image);
-    p.drawImage(old_image.rect(), old_image);
-    c->GetCanvasWidget()->SetImage(new_image);
+    // Every layer is resized, new background pixels take the secondary color.
+    c->GetCanvasWidget()->ResizeImage(dialog.new_size(), dialog.offset(), options_cache_->alt_color());
+  }
+}
+
+void ActionHandler::ZoomImage2x() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->ZoomImage(2);
+  }
+}
+
+void ActionHandler::ZoomImage4x() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->ZoomImage(4);
+  }
+}
+
+void ActionHandler::CreateShadow() const {
+  ShadowDialog dialog(window_cache_);
+  if (dialog.exec() != QDialog::Accepted) {
+    return;
+  }
+  if (dialog.whole_sheet()) {
+    ImageCanvasWidget *w = CurrentCanvas();
+    if (nullptr != w) {
+      w->CreateShadow(options_cache_->grid_size(), dialog.offset(), dialog.radius(), dialog.color());
+    }
+  } else {
+    window_cache_->edit_widget()->CreateShadow(dialog.offset(), dialog.radius(), dialog.color());
+  }
+}
+
+void ActionHandler::NewLayer() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr == w) {
+    return;
+  }
+  w->layers()->AddLayer(QString("Layer %1").arg(w->layers()->count()));
+  LayersChanged(w);
+}
+
+void ActionHandler::DeleteLayer() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr == w || w->layers()->count() <= 1) {
+    return;
+  }
+  int ans = QMessageBox::question(window_cache_, "Delete layer...", QString("Do you want to delete the layer \"%1\"?").arg(w->layers()->layer(w->layers()->active()).name), QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+  if (ans == QMessageBox::Yes) {
+    w->layers()->RemoveLayer(w->layers()->active());
+    LayersChanged(w);
+  }
+}
+
+void ActionHandler::MoveLayerUp() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->layers()->MoveLayer(w->layers()->active(), w->layers()->active() + 1);
+    LayersChanged(w);
+  }
+}
+
+void ActionHandler::MoveLayerDown() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->layers()->MoveLayer(w->layers()->active(), w->layers()->active() - 1);
+    LayersChanged(w);
+  }
+}
+
+void ActionHandler::SelectLayerAbove() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->layers()->set_active(w->layers()->active() + 1);
+    LayersChanged(w);
+  }
+}
+
+void ActionHandler::SelectLayerBelow() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->layers()->set_active(w->layers()->active() - 1);
+    LayersChanged(w);
+  }
+}
+
+void ActionHandler::ToggleLayerVisibility() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    int active = w->layers()->active();
+    w->layers()->SetVisible(active, !w->layers()->layer(active).visible);
+    LayersChanged(w);
+  }
+}
+
+void ActionHandler::LayerProperties() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr == w) {
+    return;
+  }
+  int active = w->layers()->active();
+  const LayerStack::Layer &layer = w->layers()->layer(active);
+  LayerPropertiesDialog dialog(layer.name, layer.opacity, layer.blend_mode, window_cache_);
+  if (dialog.exec() == QDialog::Accepted) {
+    w->layers()->SetName(active, dialog.name());
+    w->layers()->SetOpacity(active, dialog.opacity());
+    w->layers()->SetBlendMode(active, dialog.blend_mode());
+    LayersChanged(w);
   }
 }
 
@@ -358,11 +524,125 @@ void ActionHandler::Translate(const QString &language) const {
   pApp->Translate(language);
 }
 
-void ActionHandler::CreateImageCanvas(const QImage &image, const QString &file_name) const {
+void ActionHandler::NewFrame() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->AddFrame();
+    FramesChanged(w);
+  }
+}
+
+void ActionHandler::DeleteFrame() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr == w || w->SyncTimeline()->size() <= 1) {
+    return;
+  }
+  int ans = QMessageBox::question(window_cache_, "Delete frame...", QString("Do you want to delete the frame %1?").arg(w->current_frame() + 1), QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+  if (ans == QMessageBox::Yes) {
+    w->DeleteFrame();
+    FramesChanged(w);
+  }
+}
+
+void ActionHandler::PreviousFrame() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w && w->current_frame() > 0) {
+    w->ShowFrame(w->current_frame() - 1);
+    FramesChanged(w);
+  }
+}
+
+void ActionHandler::NextFrame() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w && w->current_frame() + 1 < w->SyncTimeline()->size()) {
+    w->ShowFrame(w->current_frame() + 1);
+    FramesChanged(w);
+  }
+}
+
+void ActionHandler::MakeKeyframe() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->MakeKeyframe();
+    FramesChanged(w);
+  }
+}
+
+void ActionHandler::ToggleOnionSkin(bool onion_skin) const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w) {
+    w->set_onion_skin(onion_skin);
+  }
+}
+
+void ActionHandler::NewVoxelModel() const {
+  bool ok = false;
+  int size = QInputDialog::getInt(window_cache_, "New voxel model...", "Model size (width, depth and height):", kDefaultVoxelModelSize, 1, kMaxVoxelModelSize, 1, &ok);
+  if (!ok) {
+    return;
+  }
+  QImage placeholder(1, 1, QImage::Format_ARGB32_Premultiplied);
+  placeholder.fill(Qt::transparent);
+  ImageCanvasContainer *canvas_container = CreateImageCanvas(placeholder, "");
+  ImageCanvasWidget *w = canvas_container->GetCanvasWidget();
+  w->SetVoxelModel(QSize(size, size), size);
+  canvas_container->parentWidget()->resize(w->size() + QSize(50, 50));
+  SliceChanged(w);
+}
+
+void ActionHandler::SliceAbove() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w && w->voxel_mode() && w->current_slice() + 1 < w->slice_count()) {
+    w->ShowSlice(w->current_slice() + 1);
+    SliceChanged(w);
+  }
+}
+
+void ActionHandler::SliceBelow() const {
+  ImageCanvasWidget *w = CurrentCanvas();
+  if (nullptr != w && w->voxel_mode() && w->current_slice() > 0) {
+    w->ShowSlice(w->current_slice() - 1);
+    SliceChanged(w);
+  }
+}
+
+ImageCanvasWidget *ActionHandler::CurrentCanvas() const {
+  ImageCanvasContainer *c = window_cache_->current_canvas_container();
+  return nullptr == c ? nullptr : c->GetCanvasWidget();
+}
+
+void ActionHandler::LayersChanged(ImageCanvasWidget *canvas) const {
+  canvas->RefreshLayers();
+  canvas->UnsaveState();
+  // The edit area must follow the active layer.
+  canvas->SendSelection();
+  const LayerStack *layers = canvas->layers();
+  const LayerStack::Layer &layer = layers->layer(layers->active());
+  pApp->SetStatusMessage(QString("%1 (%2/%3)%4").arg(layer.name).arg(layers->active() + 1).arg(layers->count()).arg(layer.visible ? "" : " - hidden"));
+}
+
+void ActionHandler::FramesChanged(ImageCanvasWidget *canvas) const {
+  // The edit area must follow the shown frame.
+  canvas->SendSelection();
+  const AnimationTimeline *timeline = canvas->SyncTimeline();
+  if (!timeline->isNull()) {
+    int frame = canvas->current_frame();
+    pApp->SetStatusMessage(QString("Frame %1/%2%3").arg(frame + 1).arg(timeline->size()).arg(timeline->IsKeyframe(frame) ? " - keyframe" : ""));
+  }
+}
+
+void ActionHandler::SliceChanged(ImageCanvasWidget *canvas) const {
+  // The edit area must follow the shown slice.
+  canvas->SendSelection();
+  pApp->SetStatusMessage(QString("Slice %1/%2").arg(canvas->current_slice() + 1).arg(canvas->slice_count()));
+}
+
+ImageCanvasContainer *ActionHandler::CreateImageCanvas(const QImage &image, const QString &file_name) const {
   ImageCanvasContainer *canvas_container = new ImageCanvasContainer(image, file_name);
   QMdiArea *mdi = window_cache_->mdi_area();
   QMdiSubWindow *w = mdi->addSubWindow(canvas_container);
   QSize size = image.size() + QSize(50, 50);
   w->resize(size);
   w->show();
+  return canvas_container;
 }
@@ -24,6 +24,8 @@
 #include <QMap>
 
 class GlobalOptions;
+class ImageCanvasContainer;
+class ImageCanvasWidget;
 class MainWindow;
 class QAction;
 
@@ -71,11 +73,38 @@ public slots:
   void SetColorGradient() const;
   void LoadPalette() const;
   void SavePalette() const;
+  void PaletteFromImage() const;
   void DefaultPalette() const;
   void LoadSavedPalette() const;
   void ToggleShowGrid(bool show) const;
   void ToggleShowPixelGrid(bool show) const;
   void ImageSize() const;
+  void ZoomImage2x() const;
+  void ZoomImage4x() const;
+  void CreateShadow() const;
+
+  // Layer Actions
+  void NewLayer() const;
+  void DeleteLayer() const;
+  void MoveLayerUp() const;
+  void MoveLayerDown() const;
+  void SelectLayerAbove() const;
+  void SelectLayerBelow() const;
+  void ToggleLayerVisibility() const;
+  void LayerProperties() const;
+
+  // Animation Actions
+  void NewFrame() const;
+  void DeleteFrame() const;
+  void PreviousFrame() const;
+  void NextFrame() const;
+  void MakeKeyframe() const;
+  void ToggleOnionSkin(bool onion_skin) const;
+
+  // Voxel Actions
+  void NewVoxelModel() const;
+  void SliceAbove() const;
+  void SliceBelow() const;
 
   // Language Actions
   void Translate(const QString &language) const;
@@ -90,7 +119,11 @@ private:
   MainWindow *window_cache_;
   QMap<QAction *, int> tool_action_map_;
 
-  void CreateImageCanvas(const QImage &image, const QString &file_name) const;
+  ImageCanvasContainer *CreateImageCanvas(const QImage &image, const QString &file_name) const;
+  ImageCanvasWidget *CurrentCanvas() const;
+  void LayersChanged(ImageCanvasWidget *canvas) const;
+  void FramesChanged(ImageCanvasWidget *canvas) const;
+  void SliceChanged(ImageCanvasWidget *canvas) const;
 };
 
 #endif // ACTION_HANDLER_H
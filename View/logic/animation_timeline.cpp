@@ -0,0 +1,225 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "animation_timeline.h"
+
+#include <QPainter>
+
+const QColor kOnionPreviousTint(255, 0, 0, 128);
+const QColor kOnionNextTint(0, 0, 255, 128);
+const qreal kOnionOpacity = 0.35;
+
+quint64 FrameTileKey(int column, int row) {
+  return (quint64(quint32(column)) << 32) | quint32(row);
+}
+
+AnimationTimeline::Frame::Frame() : keyframe(false),
+                                    version(0) {
+}
+
+AnimationTimeline::AnimationTimeline() : next_version_(1),
+                                         onion_previous_(0),
+                                         onion_next_(0) {
+}
+
+void AnimationTimeline::Reset(const QImage &first) {
+  Clear();
+  Frame frame;
+  frame.keyframe = true;
+  frame.image = TiledImage(first);
+  frame.version = next_version_++;
+  frames_.push_back(frame);
+}
+
+void AnimationTimeline::Clear() {
+  frames_.clear();
+  onion_ = QImage();
+}
+
+bool AnimationTimeline::isNull() const {
+  return frames_.isEmpty();
+}
+
+int AnimationTimeline::size() const {
+  return frames_.size();
+}
+
+bool AnimationTimeline::IsKeyframe(int index) const {
+  return frames_[index].keyframe;
+}
+
+quint64 AnimationTimeline::version(int index) const {
+  return frames_[index].version;
+}
+
+TiledImage AnimationTimeline::frame(int index) const {
+  const Frame &f = frames_[index];
+  if (f.keyframe) {
+    return f.image;
+  }
+  TiledImage image = frames_[KeyOf(index)].image;
+  for (auto it = f.delta.constBegin(); it != f.delta.constEnd(); ++it) {
+    image.SetTile(int(it.key() >> 32), int(it.key() & 0xffffffff), it.value());
+  }
+  return image;
+}
+
+void AnimationTimeline::SetFrame(int index, const QImage &image) {
+  int key = KeyOf(index);
+  Frame &f = frames_[index];
+
+  if (index != key && image.size() != frames_[key].image.size()) {
+    // A frame of another size can not be stored against its keyframe.
+    MakeKeyframe(index);
+    key = index;
+  }
+
+  if (index == key) {
+    // The frames after a keyframe are stored against it, decode them before
+    // it changes. They keep their versions, their pixels stay the same.
+    int end = GroupEnd(key);
+    QVector<TiledImage> dependents;
+    for (int i = key + 1; i < end; i++) {
+      dependents.push_back(frame(i));
+    }
+    f.image = f.image.Updated(image);
+    const TiledImage *current_key = &f.image;
+    for (int i = key + 1; i < end; i++) {
+      const TiledImage &d = dependents[i - key - 1];
+      Frame &dependent = frames_[i];
+      if (d.size() != current_key->size()) {
+        // A frame that no longer matches the keyframe size becomes one.
+        dependent.keyframe = true;
+        dependent.image = d;
+        dependent.delta.clear();
+        current_key = &dependent.image;
+      } else {
+        dependent.delta = Delta(*current_key, d);
+      }
+    }
+  } else {
+    const TiledImage &key_image = frames_[key].image;
+    f.delta = Delta(key_image, key_image.Updated(image));
+  }
+  f.version = next_version_++;
+}
+
+void AnimationTimeline::InsertFrame(int index, const QImage &image) {
+  Frame frame;
+  frame.version = next_version_++;
+  if (index == 0 || frames_.isEmpty()) {
+    frame.keyframe = true;
+    frame.image = TiledImage(image);
+    frames_.insert(0, frame);
+    return;
+  }
+  frames_.insert(index, frame);
+  SetFrame(index, image);
+}
+
+void AnimationTimeline::RemoveFrame(int index) {
+  if (frames_.size() <= 1) {
+    return;
+  }
+  if (frames_[index].keyframe && index + 1 < frames_.size()) {
+    // The next frame takes over as keyframe of the frames after this one.
+    MakeKeyframe(index + 1);
+  }
+  frames_.remove(index);
+}
+
+void AnimationTimeline::MakeKeyframe(int index) {
+  if (frames_[index].keyframe) {
+    return;
+  }
+  int end = GroupEnd(KeyOf(index));
+  QVector<TiledImage> group;
+  for (int i = index; i < end; i++) {
+    group.push_back(frame(i));
+  }
+  Frame &f = frames_[index];
+  f.keyframe = true;
+  f.image = group[0];
+  f.delta.clear();
+  for (int i = index + 1; i < end; i++) {
+    frames_[i].delta = Delta(f.image, group[i - index]);
+  }
+}
+
+QImage AnimationTimeline::OnionSkin(int index) const {
+  quint64 previous = index > 0 ? frames_[index - 1].version : 0;
+  quint64 next = index + 1 < frames_.size() ? frames_[index + 1].version : 0;
+  QSize size = frames_[index].keyframe ? frames_[index].image.size() : frames_[KeyOf(index)].image.size();
+  if (!onion_.isNull() && onion_.size() == size && previous == onion_previous_ && next == onion_next_) {
+    return onion_;
+  }
+
+  onion_ = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  onion_.fill(0x0);
+  QPainter painter(&onion_);
+  painter.setOpacity(kOnionOpacity);
+  if (previous != 0) {
+    DrawTinted(&painter, frame(index - 1).ToImage(), kOnionPreviousTint);
+  }
+  if (next != 0) {
+    DrawTinted(&painter, frame(index + 1).ToImage(), kOnionNextTint);
+  }
+  painter.end();
+  onion_previous_ = previous;
+  onion_next_ = next;
+  return onion_;
+}
+
+int AnimationTimeline::KeyOf(int index) const {
+  while (index > 0 && !frames_[index].keyframe) {
+    index--;
+  }
+  return index;
+}
+
+int AnimationTimeline::GroupEnd(int key) const {
+  int end = key + 1;
+  while (end < frames_.size() && !frames_[end].keyframe) {
+    end++;
+  }
+  return end;
+}
+
+QHash<quint64, QImage> AnimationTimeline::Delta(const TiledImage &key, const TiledImage &image) {
+  // |image| comes from the keyframe, untouched tiles are still shared with it.
+  QHash<quint64, QImage> delta;
+  for (int row = 0; row < image.rows(); row++) {
+    for (int column = 0; column < image.columns(); column++) {
+      const QImage &tile = image.tile(column, row);
+      if (tile.cacheKey() != key.tile(column, row).cacheKey()) {
+        delta.insert(FrameTileKey(column, row), tile);
+      }
+    }
+  }
+  return delta;
+}
+
+void AnimationTimeline::DrawTinted(QPainter *painter, const QImage &image, const QColor &tint) {
+  QImage tinted = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  QPainter tint_painter(&tinted);
+  tint_painter.setCompositionMode(QPainter::CompositionMode_SourceAtop);
+  tint_painter.fillRect(tinted.rect(), tint);
+  tint_painter.end();
+  painter->drawImage(0, 0, tinted);
+}
@@ -0,0 +1,86 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef ANIMATION_TIMELINE_H
+#define ANIMATION_TIMELINE_H
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+#include "logic/tiled_image.h"
+
+/*!
+ * \brief Frames of an animated document.
+ *
+ * Keyframes are stored whole. Every other frame only keeps the tiles that
+ * differ from the keyframe before it, the rest is shared with it. Each change
+ * to a frame gives it a new version number, so views can cache what they
+ * draw from it.
+ */
+class AnimationTimeline {
+public:
+  AnimationTimeline();
+
+  // Starts over with |first| as the only frame.
+  void Reset(const QImage &first);
+  void Clear();
+
+  bool isNull() const;
+  int size() const;
+  bool IsKeyframe(int index) const;
+  // Unique per frame content, never 0.
+  quint64 version(int index) const;
+
+  TiledImage frame(int index) const;
+  void SetFrame(int index, const QImage &image);
+  void InsertFrame(int index, const QImage &image);
+  void RemoveFrame(int index);
+  // Stores |index| whole and the frames after it as changes against it.
+  void MakeKeyframe(int index);
+
+  // The frames before and after |index| tinted and faded over each other.
+  // Only rebuilt when one of them changed.
+  QImage OnionSkin(int index) const;
+
+private:
+  struct Frame {
+    Frame();
+
+    bool keyframe;
+    TiledImage image;
+    QHash<quint64, QImage> delta;
+    quint64 version;
+  };
+
+  QVector<Frame> frames_;
+  quint64 next_version_;
+
+  mutable QImage onion_;
+  mutable quint64 onion_previous_;
+  mutable quint64 onion_next_;
+
+  int KeyOf(int index) const;
+  int GroupEnd(int key) const;
+  static QHash<quint64, QImage> Delta(const TiledImage &key, const TiledImage &image);
+  static void DrawTinted(QPainter *painter, const QImage &image, const QColor &tint);
+};
+
+#endif // ANIMATION_TIMELINE_H
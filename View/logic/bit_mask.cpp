@@ -0,0 +1,342 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "bit_mask.h"
+
+#include <QtAlgorithms>
+#include <cstring>
+
+#include "pixel_format.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BIT_MASK_SSE2
+#endif
+
+const int kWordBits = 64;
+
+namespace {
+// Shifts a row of |words| words by |shift| bits, towards higher x when
+// positive. Bits shifted in are clear.
+void ShiftRow(const quint64 *in, quint64 *out, int words, int shift) {
+  const int word_shift = qAbs(shift) / kWordBits;
+  const int bit_shift = qAbs(shift) % kWordBits;
+  for (int i = 0; i < words; i++) {
+    int source = shift >= 0 ? i - word_shift : i + word_shift;
+    quint64 w = (source >= 0 && source < words) ? in[source] : 0;
+    if (bit_shift == 0) {
+      out[i] = w;
+      continue;
+    }
+    // The neighbour word the carried bits come from.
+    int carry = shift >= 0 ? source - 1 : source + 1;
+    quint64 c = (carry >= 0 && carry < words) ? in[carry] : 0;
+    out[i] = shift >= 0 ? (w << bit_shift) | (c >> (kWordBits - bit_shift))
+                        : (w >> bit_shift) | (c << (kWordBits - bit_shift));
+  }
+}
+
+void OrRow(quint64 *out, const quint64 *in, int words) {
+  int i = 0;
+#ifdef BIT_MASK_SSE2
+  for (; i + 2 <= words; i += 2) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_or_si128(a, b));
+  }
+#endif
+  for (; i < words; i++) {
+    out[i] |= in[i];
+  }
+}
+}
+
+BitMask::BitMask() : width_(0),
+                     height_(0),
+                     words_per_row_(0) {
+}
+
+BitMask::BitMask(const QSize &size, bool value) : width_(qMax(0, size.width())),
+                                                  height_(qMax(0, size.height())),
+                                                  words_per_row_((width_ + kWordBits - 1) / kWordBits) {
+  words_.resize(words_per_row_ * height_);
+  Fill(value);
+}
+
+BitMask BitMask::FromColor(const QImage &image, uint color) {
+  BitMask mask(image.size());
+  bool indexed = image.format() == QImage::Format_Indexed8;
+  // Premultiplied pixels are compared as they are, no conversion for
+  // documents in their canonical format.
+  QImage source = indexed ? image : image.convertToFormat(PixelFormat::kTrueColor);
+  uint match = indexed ? color : qPremultiply(color);
+  for (int y = 0; y < source.height(); y++) {
+    quint64 *row = mask.words_.data() + y * mask.words_per_row_;
+    if (indexed) {
+      const uchar *in = source.constScanLine(y);
+      for (int x = 0; x < source.width(); x++) {
+        row[x / kWordBits] |= quint64(in[x] == match) << (x % kWordBits);
+      }
+    } else {
+      const QRgb *in = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+      for (int x = 0; x < source.width(); x++) {
+        row[x / kWordBits] |= quint64(in[x] == match) << (x % kWordBits);
+      }
+    }
+  }
+  return mask;
+}
+
+BitMask BitMask::FromAlpha(const QImage &image) {
+  BitMask mask(image.size());
+  // Alpha reads the same premultiplied or not.
+  QImage source = image.convertToFormat(PixelFormat::kTrueColor);
+  for (int y = 0; y < source.height(); y++) {
+    quint64 *row = mask.words_.data() + y * mask.words_per_row_;
+    const QRgb *in = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+    for (int x = 0; x < source.width(); x++) {
+      row[x / kWordBits] |= quint64(qAlpha(in[x]) != 0) << (x % kWordBits);
+    }
+  }
+  return mask;
+}
+
+bool BitMask::isNull() const {
+  return words_.isEmpty();
+}
+
+QSize BitMask::size() const {
+  return QSize(width_, height_);
+}
+
+int BitMask::width() const {
+  return width_;
+}
+
+int BitMask::height() const {
+  return height_;
+}
+
+bool BitMask::test(int x, int y) const {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return false;
+  }
+  return (words_[y * words_per_row_ + x / kWordBits] >> (x % kWordBits)) & 1;
+}
+
+void BitMask::set(int x, int y, bool value) {
+  if (x < 0 || y < 0 || x >= width_ || y >= height_) {
+    return;
+  }
+  quint64 &word = words_[y * words_per_row_ + x / kWordBits];
+  quint64 bit = quint64(1) << (x % kWordBits);
+  word = value ? (word | bit) : (word & ~bit);
+}
+
+bool BitMask::IsEmpty() const {
+  for (quint64 w : words_) {
+    if (w != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BitMask::Fill(bool value) {
+  words_.fill(value ? ~quint64(0) : 0);
+  ClearPadding();
+}
+
+void BitMask::FillRect(const QRect &rect, bool value) {
+  QRect r = rect.intersected(QRect(0, 0, width_, height_));
+  if (r.isEmpty()) {
+    return;
+  }
+  // Bits of the rect inside each word column, built once for all rows.
+  QVector<quint64> span(words_per_row_, 0);
+  for (int w = r.left() / kWordBits; w <= r.right() / kWordBits; w++) {
+    int first = qMax(r.left() - w * kWordBits, 0);
+    int last = qMin(r.right() - w * kWordBits, kWordBits - 1);
+    quint64 high = last == kWordBits - 1 ? ~quint64(0) : (quint64(1) << (last + 1)) - 1;
+    span[w] = high & ~((quint64(1) << first) - 1);
+  }
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    quint64 *row = words_.data() + y * words_per_row_;
+    for (int w = r.left() / kWordBits; w <= r.right() / kWordBits; w++) {
+      row[w] = value ? (row[w] | span[w]) : (row[w] & ~span[w]);
+    }
+  }
+}
+
+void BitMask::Invert() {
+  for (quint64 &w : words_) {
+    w = ~w;
+  }
+  ClearPadding();
+}
+
+void BitMask::Unite(const BitMask &other) {
+  if (other.size() != size()) {
+    return;
+  }
+  quint64 *out = words_.data();
+  const quint64 *in = other.words_.constData();
+  for (int i = 0; i < words_.size(); i++) {
+    out[i] |= in[i];
+  }
+}
+
+void BitMask::Intersect(const BitMask &other) {
+  if (other.size() != size()) {
+    return;
+  }
+  quint64 *out = words_.data();
+  const quint64 *in = other.words_.constData();
+  for (int i = 0; i < words_.size(); i++) {
+    out[i] &= in[i];
+  }
+}
+
+void BitMask::Subtract(const BitMask &other) {
+  if (other.size() != size()) {
+    return;
+  }
+  quint64 *out = words_.data();
+  const quint64 *in = other.words_.constData();
+  for (int i = 0; i < words_.size(); i++) {
+    out[i] &= ~in[i];
+  }
+}
+
+void BitMask::Dilate(int radius) {
+  if (isNull() || radius <= 0) {
+    return;
+  }
+  const int span = 2 * radius + 1;
+
+  // Horizontal pass. Rows are widened by a margin on both sides so nothing
+  // that comes back in range is shifted out on the way.
+  const int margin = (radius + kWordBits - 1) / kWordBits;
+  const int words = words_per_row_ + 2 * margin;
+  QVector<quint64> acc(words);
+  QVector<quint64> shifted(words);
+  for (int y = 0; y < height_; y++) {
+    quint64 *row = words_.data() + y * words_per_row_;
+    acc.fill(0);
+    std::memcpy(acc.data() + margin, row, words_per_row_ * sizeof(quint64));
+    // Doubles the covered window [x - covered + 1, x] each step.
+    for (int covered = 1; covered < span;) {
+      int step = qMin(covered, span - covered);
+      ShiftRow(acc.constData(), shifted.data(), words, step);
+      OrRow(acc.data(), shifted.constData(), words);
+      covered += step;
+    }
+    // Centers the window on x.
+    ShiftRow(acc.constData(), shifted.data(), words, -radius);
+    std::memcpy(row, shifted.constData() + margin, words_per_row_ * sizeof(quint64));
+  }
+  ClearPadding();
+
+  // Vertical pass, the same doubling on whole rows, with |radius| spare rows
+  // below.
+  QVector<quint64> rows((height_ + radius) * words_per_row_, 0);
+  std::memcpy(rows.data(), words_.constData(), words_.size() * sizeof(quint64));
+  for (int covered = 1; covered < span;) {
+    int step = qMin(covered, span - covered);
+    // Bottom up, so every row reads the one above it before it changes.
+    for (int y = height_ + radius - 1; y >= step; y--) {
+      OrRow(rows.data() + y * words_per_row_, rows.constData() + (y - step) * words_per_row_, words_per_row_);
+    }
+    covered += step;
+  }
+  std::memcpy(words_.data(), rows.constData() + radius * words_per_row_, words_.size() * sizeof(quint64));
+}
+
+void BitMask::Translate(const QPoint &offset) {
+  if (isNull() || offset.isNull()) {
+    return;
+  }
+  QVector<quint64> moved(words_.size(), 0);
+  for (int y = 0; y < height_; y++) {
+    int source = y - offset.y();
+    if (source < 0 || source >= height_) {
+      continue;
+    }
+    ShiftRow(words_.constData() + source * words_per_row_, moved.data() + y * words_per_row_, words_per_row_, offset.x());
+  }
+  words_ = moved;
+  ClearPadding();
+}
+
+void BitMask::RestoreMasked(QImage *image, const QImage &original, const QPoint &origin) const {
+  QRect r = QRect(origin, original.size()).intersected(QRect(0, 0, width_, height_)).intersected(image->rect());
+  if (r.isEmpty()) {
+    return;
+  }
+  const int bytes_per_pixel = image->depth() / 8;
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    const quint64 *row = words_.constData() + y * words_per_row_;
+    uchar *out = image->scanLine(y);
+    const uchar *in = original.constScanLine(y - origin.y());
+    for (int w = r.left() / kWordBits; w <= r.right() / kWordBits; w++) {
+      // Unmasked runs of 64 pixels are skipped in one test.
+      quint64 bits = row[w];
+      while (bits != 0) {
+        int x = w * kWordBits + qCountTrailingZeroBits(bits);
+        bits &= bits - 1;
+        if (x >= r.left() && x <= r.right()) {
+          std::memcpy(out + x * bytes_per_pixel, in + (x - origin.x()) * bytes_per_pixel, bytes_per_pixel);
+        }
+      }
+    }
+  }
+}
+
+QImage BitMask::ToImage(QRgb color) const {
+  QImage image(width_, height_, PixelFormat::kTrueColor);
+  image.fill(0);
+  color = qPremultiply(color);
+  for (int y = 0; y < height_; y++) {
+    const quint64 *row = words_.constData() + y * words_per_row_;
+    QRgb *out = reinterpret_cast<QRgb *>(image.scanLine(y));
+    for (int w = 0; w < words_per_row_; w++) {
+      quint64 bits = row[w];
+      while (bits != 0) {
+        out[w * kWordBits + qCountTrailingZeroBits(bits)] = color;
+        bits &= bits - 1;
+      }
+    }
+  }
+  return image;
+}
+
+quint64 BitMask::TailMask() const {
+  int tail = width_ % kWordBits;
+  return tail == 0 ? ~quint64(0) : (quint64(1) << tail) - 1;
+}
+
+void BitMask::ClearPadding() {
+  if (words_per_row_ == 0) {
+    return;
+  }
+  quint64 tail = TailMask();
+  for (int y = 0; y < height_; y++) {
+    words_[y * words_per_row_ + words_per_row_ - 1] &= tail;
+  }
+}
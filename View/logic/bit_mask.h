@@ -0,0 +1,85 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef BIT_MASK_H
+#define BIT_MASK_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+/*!
+ * \brief One bit per pixel mask, 64 pixels per word.
+ *
+ * Rows are padded to whole words and the padding bits are always clear, so
+ * whole rows can be combined word by word. A 4096x4096 mask takes 2 MB.
+ *
+ * Only protection masks are built on it. Selections are still rectangles
+ * lifted by FloatingSelection, there is no selection mask yet.
+ */
+class BitMask {
+public:
+  BitMask();
+  explicit BitMask(const QSize &size, bool value = false);
+
+  // Bits set where |image| pixels equal |color| (a palette index for
+  // Indexed8 images, see IndexedColor::PixelValue).
+  static BitMask FromColor(const QImage &image, uint color);
+  // Bits set where |image| pixels are not fully transparent.
+  static BitMask FromAlpha(const QImage &image);
+
+  bool isNull() const;
+  QSize size() const;
+  int width() const;
+  int height() const;
+
+  bool test(int x, int y) const;
+  void set(int x, int y, bool value);
+  bool IsEmpty() const;
+
+  void Fill(bool value);
+  void FillRect(const QRect &rect, bool value);
+  void Invert();
+  void Unite(const BitMask &other);
+  void Intersect(const BitMask &other);
+  void Subtract(const BitMask &other);
+  // Grows the set bits by |radius| pixels in every direction (a square). It
+  // runs as a horizontal and a vertical pass, each in log2(radius) steps of
+  // whole word shifts and ORs.
+  void Dilate(int radius);
+  // Moves every bit by |offset|, bits moved out of the mask are lost.
+  void Translate(const QPoint &offset);
+
+  // Puts back the pixels of |original| (taken at |origin|) wherever a bit is
+  // set, undoing any painting done to them.
+  void RestoreMasked(QImage *image, const QImage &original, const QPoint &origin) const;
+  // |color| where bits are set, transparent elsewhere.
+  QImage ToImage(QRgb color) const;
+
+private:
+  int width_;
+  int height_;
+  int words_per_row_;
+  QVector<quint64> words_;
+
+  quint64 TailMask() const;
+  void ClearPadding();
+};
+
+#endif // BIT_MASK_H
@@ -0,0 +1,101 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "floating_selection.h"
+
+#include "logic/bit_mask.h"
+#include "logic/tool_algorithm.h"
+
+FloatingSelection::FloatingSelection() {
+}
+
+FloatingSelection::FloatingSelection(const QImage &image, const QRect &source, const QColor &fill) : pixels_(image),
+                                                                                                      source_(source.intersected(image.rect())),
+                                                                                                      hole_(source_),
+                                                                                                      hole_color_(fill) {
+}
+
+FloatingSelection::FloatingSelection(const QImage &image) : pixels_(image),
+                                                            source_(image.rect()) {
+}
+
+bool FloatingSelection::isNull() const {
+  return pixels_.isNull() || source_.isEmpty();
+}
+
+QSize FloatingSelection::size() const {
+  return source_.size();
+}
+
+QRect FloatingSelection::hole() const {
+  return hole_;
+}
+
+QColor FloatingSelection::hole_color() const {
+  return hole_color_;
+}
+
+QImage FloatingSelection::ToImage() const {
+  if (isNull()) {
+    return QImage();
+  }
+  return source_ == pixels_.rect() ? pixels_ : pixels_.copy(source_);
+}
+
+FloatingSelection FloatingSelection::Pixels() const {
+  FloatingSelection pixels(*this);
+  pixels.hole_ = QRect();
+  return pixels;
+}
+
+void FloatingSelection::Replace(const QImage &image) {
+  pixels_ = image;
+  source_ = image.rect();
+}
+
+void FloatingSelection::Draw(QPainter *painter, const QRect &target) const {
+  if (!isNull()) {
+    painter->drawImage(target, pixels_, source_);
+  }
+}
+
+void FloatingSelection::Commit(QImage *image, const QRect &target, const BitMask *mask) {
+  // Put back where it was taken from, untouched: the document already holds
+  // these pixels.
+  bool in_place = hole_.isValid() && target == hole_ && source_ == hole_ && pixels_.cacheKey() == image->cacheKey();
+
+  QRect visible = target.intersected(image->rect());
+  QImage landed;
+  if (!in_place && !isNull() && !visible.isEmpty()) {
+    landed = pixels_.copy(visible.translated(source_.topLeft() - target.topLeft()));
+  }
+  // Drop the shared handle first so writing to |image| does not detach a
+  // copy of all of it.
+  pixels_ = QImage();
+
+  if (!in_place) {
+    if (hole_.isValid()) {
+      ToolAlgorithm::FillRect(image, hole_, hole_color_, mask);
+    }
+    if (!landed.isNull()) {
+      ToolAlgorithm::DrawImage(image, visible, landed, mask);
+    }
+  }
+  *this = FloatingSelection();
+}
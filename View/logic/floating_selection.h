@@ -0,0 +1,73 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef FLOATING_SELECTION_H
+#define FLOATING_SELECTION_H
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+
+class BitMask;
+
+/*!
+ * \brief Pixels picked up by the selection tool, waiting to be put down.
+ *
+ * A lifted selection keeps a shared handle on the image it came from plus the
+ * lifted rect, so nothing is copied while it is dragged around. The lifted
+ * area (the hole) is only cleared, and the pixels only copied to where they
+ * land, when the selection is committed.
+ */
+class FloatingSelection {
+public:
+  FloatingSelection();
+  // Refers to |source| of |image| without copying it. Committing clears
+  // |source| with |fill|.
+  FloatingSelection(const QImage &image, const QRect &source, const QColor &fill);
+  // Floats |image| as a whole, with no hole left behind (pasted pixels).
+  explicit FloatingSelection(const QImage &image);
+
+  bool isNull() const;
+  QSize size() const;
+  // Area still to be cleared in the document, null when there is none.
+  QRect hole() const;
+  QColor hole_color() const;
+
+  // Copy of the floating pixels.
+  QImage ToImage() const;
+  // Same pixels, still shared, with no hole left behind.
+  FloatingSelection Pixels() const;
+  // Swaps the floating pixels for transformed ones, the hole stays.
+  void Replace(const QImage &image);
+  // Draws the floating pixels scaled into |target|, straight from the view.
+  void Draw(QPainter *painter, const QRect &target) const;
+  // Clears the hole in |image| and writes the pixels at |target|, skipping
+  // protected pixels. Only the part of |target| inside |image| is copied, an
+  // empty |target| just clears the hole. The selection is null afterwards.
+  void Commit(QImage *image, const QRect &target, const BitMask *mask = nullptr);
+
+private:
+  QImage pixels_;
+  QRect source_;
+  QRect hole_;
+  QColor hole_color_;
+};
+
+#endif // FLOATING_SELECTION_H
@@ -0,0 +1,81 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "hibernation.h"
+
+#include <QDataStream>
+
+#include "logic/layer_stack.h"
+
+// Pixel art compresses well and fast at the lowest zlib level.
+const int kCompressionLevel = 1;
+// Compressed documents bigger than this go to disk.
+const int kMaxResidentBytes = 4 * 1024 * 1024;
+
+Hibernation::Hibernation() {
+}
+
+bool Hibernation::isNull() const {
+  return data_.isEmpty() && file_.isNull();
+}
+
+int Hibernation::resident_bytes() const {
+  return data_.size();
+}
+
+bool Hibernation::Store(const LayerStack &layers) {
+  Clear();
+
+  QByteArray raw;
+  QDataStream out(&raw, QIODevice::WriteOnly);
+  layers.Serialize(&out);
+  QByteArray compressed = qCompress(raw, kCompressionLevel);
+  raw.clear();
+
+  if (compressed.size() > kMaxResidentBytes) {
+    QScopedPointer<QTemporaryFile> file(new QTemporaryFile());
+    if (file->open() && file->write(compressed) == compressed.size() && file->flush()) {
+      file_.swap(file);
+      return true;
+    }
+  }
+  data_ = compressed;
+  return true;
+}
+
+bool Hibernation::Restore(LayerStack *layers) {
+  QByteArray compressed = data_;
+  if (!file_.isNull()) {
+    file_->seek(0);
+    compressed = file_->readAll();
+  }
+  QByteArray raw = qUncompress(compressed);
+  QDataStream in(&raw, QIODevice::ReadOnly);
+  if (raw.isEmpty() || !layers->Deserialize(&in)) {
+    // Kept, a later attempt may still read it.
+    return false;
+  }
+  Clear();
+  return true;
+}
+
+void Hibernation::Clear() {
+  data_.clear();
+  file_.reset();
+}
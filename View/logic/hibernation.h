@@ -0,0 +1,56 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef HIBERNATION_H
+#define HIBERNATION_H
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QTemporaryFile>
+
+class LayerStack;
+
+/*!
+ * \brief Compressed copy of the layers of a document nobody is looking at.
+ *
+ * Small documents stay in memory compressed, bigger ones are spilled to a
+ * temporary file that is removed once they are restored.
+ */
+class Hibernation {
+public:
+  Hibernation();
+
+  bool isNull() const;
+  // Bytes kept in memory, not counting a spilled file.
+  int resident_bytes() const;
+
+  bool Store(const LayerStack &layers);
+  // Reads the layers back into |layers| and forgets them. On failure they
+  // are kept and |layers| is left alone.
+  bool Restore(LayerStack *layers);
+  void Clear();
+
+private:
+  QByteArray data_;
+  QScopedPointer<QTemporaryFile> file_;
+
+  Q_DISABLE_COPY(Hibernation)
+};
+
+#endif // HIBERNATION_H
@@ -0,0 +1,51 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "image_mime_data.h"
+
+#include <QApplication>
+#include <QClipboard>
+
+const QString kImageMimeType = "application/x-qt-image";
+
+ImageMimeData::ImageMimeData(const FloatingSelection &selection) : selection_(selection.Pixels()) {
+}
+
+FloatingSelection ImageMimeData::selection() const {
+  return selection_;
+}
+
+QStringList ImageMimeData::formats() const {
+  return QStringList() << kImageMimeType;
+}
+
+const ImageMimeData *ImageMimeData::FromClipboard() {
+  return qobject_cast<const ImageMimeData *>(QApplication::clipboard()->mimeData());
+}
+
+QVariant ImageMimeData::retrieveData(const QString &mimetype, QVariant::Type type) const {
+  if (mimetype != kImageMimeType) {
+    return QMimeData::retrieveData(mimetype, type);
+  }
+  // Another application wants the pixels, copy them out once.
+  if (image_.isNull()) {
+    image_ = selection_.ToImage();
+  }
+  return image_;
+}
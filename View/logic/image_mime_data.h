@@ -0,0 +1,55 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef IMAGE_MIME_DATA_H
+#define IMAGE_MIME_DATA_H
+
+#include <QMimeData>
+
+#include "logic/floating_selection.h"
+
+/*!
+ * \brief Clipboard data holding copied pixels by reference.
+ *
+ * Pasting inside the application takes the shared pixels straight back, the
+ * image is only materialized when another application asks the clipboard
+ * for it.
+ */
+class ImageMimeData : public QMimeData {
+  Q_OBJECT
+public:
+  explicit ImageMimeData(const FloatingSelection &selection);
+
+  // The copied pixels, with no hole attached.
+  FloatingSelection selection() const;
+
+  virtual QStringList formats() const;
+
+  // The clipboard data, if it was copied by this application.
+  static const ImageMimeData *FromClipboard();
+
+protected:
+  virtual QVariant retrieveData(const QString &mimetype, QVariant::Type type) const;
+
+private:
+  FloatingSelection selection_;
+  mutable QImage image_;
+};
+
+#endif // IMAGE_MIME_DATA_H
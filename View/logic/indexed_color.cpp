@@ -0,0 +1,105 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "indexed_color.h"
+
+#include <QSet>
+#include <climits>
+
+// Columns of the swatch image built from a document palette.
+const int kPaletteColumns = 16;
+
+int IndexedColor::NearestIndex(const QVector<QRgb> &table, QRgb color) {
+  int best = 0;
+  int best_distance = INT_MAX;
+  for (int i = 0; i < table.size(); i++) {
+    QRgb c = table[i];
+    if (c == color) {
+      return i;
+    }
+    int dr = qRed(c) - qRed(color);
+    int dg = qGreen(c) - qGreen(color);
+    int db = qBlue(c) - qBlue(color);
+    int da = qAlpha(c) - qAlpha(color);
+    int distance = dr * dr + dg * dg + db * db + da * da;
+    if (distance < best_distance) {
+      best_distance = distance;
+      best = i;
+    }
+  }
+  return best;
+}
+
+uint IndexedColor::PixelValue(const QImage &image, const QColor &color) {
+  if (image.format() == QImage::Format_Indexed8) {
+    return NearestIndex(image.colorTable(), color.rgba());
+  }
+  return color.rgba();
+}
+
+uint IndexedColor::RawPixel(const QImage &image, const QPoint &p) {
+  if (image.format() == QImage::Format_Indexed8) {
+    return image.pixelIndex(p);
+  }
+  return image.pixel(p);
+}
+
+QVector<QRgb> IndexedColor::ColorTable(const QImage &image, QVector<QRgb> table, int max_colors) {
+  QSet<QRgb> known;
+  for (QRgb c : table) {
+    known.insert(c);
+  }
+  for (int y = 0; y < image.height() && table.size() < max_colors; y++) {
+    for (int x = 0; x < image.width() && table.size() < max_colors; x++) {
+      QRgb c = image.pixel(x, y);
+      if (!known.contains(c)) {
+        known.insert(c);
+        table.push_back(c);
+      }
+    }
+  }
+  return table;
+}
+
+QImage IndexedColor::PaletteImage(const QVector<QRgb> &table) {
+  if (table.isEmpty()) {
+    return QImage();
+  }
+  int columns = qMin(kPaletteColumns, table.size());
+  int rows = (table.size() + columns - 1) / columns;
+  QImage image(columns, rows, QImage::Format_ARGB32);
+  image.fill(Qt::transparent);
+  for (int i = 0; i < table.size(); i++) {
+    image.setPixel(i % columns, i / columns, table[i]);
+  }
+  return image;
+}
+
+IndexedColor::IndexMapper::IndexMapper(const QVector<QRgb> &table) : table_(table) {
+}
+
+int IndexedColor::IndexMapper::Map(QRgb color) {
+  auto it = cache_.find(color);
+  if (it != cache_.end()) {
+    return it.value();
+  }
+  int index = NearestIndex(table_, color);
+  cache_.insert(color, index);
+  return index;
+}
@@ -0,0 +1,62 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef INDEXED_COLOR_H
+#define INDEXED_COLOR_H
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QVector>
+
+/*!
+ * \brief Helpers to edit 8 bit indexed images without converting them.
+ *
+ * Colors written into an Indexed8 image are mapped to the nearest entry of
+ * its color table, so the file keeps its palette.
+ */
+namespace IndexedColor {
+int NearestIndex(const QVector<QRgb> &table, QRgb color);
+
+// Value to store with QImage::setPixel/fill: a palette index for Indexed8
+// images, the ARGB color otherwise.
+uint PixelValue(const QImage &image, const QColor &color);
+// Raw stored value at |p|, the counterpart of PixelValue.
+uint RawPixel(const QImage &image, const QPoint &p);
+
+// Appends the distinct colors of |image| to |table|, up to |max_colors|.
+QVector<QRgb> ColorTable(const QImage &image, QVector<QRgb> table = QVector<QRgb>(), int max_colors = 256);
+// Swatch image of a color table, shown by the color palette widget.
+QImage PaletteImage(const QVector<QRgb> &table);
+
+/*!
+ * \brief Memoized NearestIndex for loops that map many pixels.
+ */
+class IndexMapper {
+public:
+  explicit IndexMapper(const QVector<QRgb> &table);
+  int Map(QRgb color);
+
+private:
+  QVector<QRgb> table_;
+  QHash<QRgb, int> cache_;
+};
+}
+
+#endif // INDEXED_COLOR_H
@@ -0,0 +1,412 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "layer_stack.h"
+
+#include "indexed_color.h"
+#include "pixel_format.h"
+
+namespace {
+void DrawTile(QPainter *painter, const LayerStack::Layer &layer, int column, int row) {
+  if (!layer.visible) {
+    return;
+  }
+  painter->setOpacity(layer.opacity);
+  painter->setCompositionMode(layer.blend_mode);
+  painter->drawImage(0, 0, layer.image.tile(column, row));
+}
+}
+
+LayerStack::LayerStack() : active_(0),
+                           above_merged_(true) {
+}
+
+void LayerStack::Reset(const QImage &image) {
+  Layer background;
+  background.name = "Background";
+  background.image = TiledImage(image);
+  background.visible = true;
+  background.opacity = 1.0;
+  background.blend_mode = QPainter::CompositionMode_SourceOver;
+
+  layers_ = {background};
+  active_ = 0;
+  RebuildCaches();
+}
+
+void LayerStack::ResetSparse(const QSize &size) {
+  Layer background;
+  background.name = "Background";
+  background.image = TiledImage::Sparse(size, PixelFormat::kTrueColor);
+  background.visible = true;
+  background.opacity = 1.0;
+  background.blend_mode = QPainter::CompositionMode_SourceOver;
+
+  layers_ = {background};
+  active_ = 0;
+  RebuildCaches();
+}
+
+void LayerStack::Resize(const QSize &size, const QPoint &offset, const QColor &fill) {
+  if (sparse() && offset.isNull()) {
+    for (Layer &layer : layers_) {
+      layer.image.Resize(size);
+    }
+    RebuildCaches();
+    return;
+  }
+  // The caches are rebuilt at the new size, let them go first.
+  below_ = above_ = composite_ = TiledImage();
+  for (int i = 0; i < layers_.size(); i++) {
+    TiledImage &image = layers_[i].image;
+    uint pixel = 0;
+    if (i == 0) {
+      pixel = image.format() == QImage::Format_Indexed8 ? IndexedColor::NearestIndex(image.color_table(), fill.rgba()) : fill.rgba();
+    }
+    image = image.Resized(size, offset, pixel);
+  }
+  RebuildCaches();
+}
+
+void LayerStack::Zoom(int factor) {
+  // The caches are rebuilt at the new size, let them go before the layers
+  // grow.
+  below_ = above_ = composite_ = TiledImage();
+  for (Layer &layer : layers_) {
+    layer.image.Zoom(factor);
+  }
+  RebuildCaches();
+}
+
+bool LayerStack::isNull() const {
+  return layers_.isEmpty();
+}
+
+bool LayerStack::sparse() const {
+  return !isNull() && layers_[0].image.sparse();
+}
+
+QSize LayerStack::size() const {
+  return composite_.size();
+}
+
+QRect LayerStack::rect() const {
+  return composite_.rect();
+}
+
+int LayerStack::count() const {
+  return layers_.size();
+}
+
+int LayerStack::active() const {
+  return active_;
+}
+
+void LayerStack::set_active(int index) {
+  if (index < 0 || index >= layers_.size() || index == active_) {
+    return;
+  }
+  active_ = index;
+  RebuildCaches();
+}
+
+const LayerStack::Layer &LayerStack::layer(int index) const {
+  return layers_[index];
+}
+
+void LayerStack::AddLayer(const QString &name) {
+  if (isNull()) {
+    return;
+  }
+  Layer layer;
+  layer.name = name;
+  layer.image = EmptyImage();
+  layer.visible = true;
+  layer.opacity = 1.0;
+  layer.blend_mode = QPainter::CompositionMode_SourceOver;
+
+  layers_.insert(active_ + 1, layer);
+  active_++;
+  RebuildCaches();
+}
+
+void LayerStack::RemoveLayer(int index) {
+  if (layers_.size() <= 1 || index < 0 || index >= layers_.size()) {
+    return;
+  }
+  layers_.remove(index);
+  if (active_ >= index && active_ > 0) {
+    active_--;
+  }
+  RebuildCaches();
+}
+
+void LayerStack::MoveLayer(int from, int to) {
+  if (from < 0 || from >= layers_.size() || to < 0 || to >= layers_.size() || from == to) {
+    return;
+  }
+  Layer layer = layers_.takeAt(from);
+  layers_.insert(to, layer);
+  if (active_ == from) {
+    active_ = to;
+  } else if (from < active_ && to >= active_) {
+    active_--;
+  } else if (from > active_ && to <= active_) {
+    active_++;
+  }
+  RebuildCaches();
+}
+
+void LayerStack::SetName(int index, const QString &name) {
+  layers_[index].name = name;
+}
+
+void LayerStack::SetVisible(int index, bool visible) {
+  layers_[index].visible = visible;
+  RebuildCaches();
+}
+
+void LayerStack::SetOpacity(int index, qreal opacity) {
+  layers_[index].opacity = qBound(0.0, opacity, 1.0);
+  RebuildCaches();
+}
+
+void LayerStack::SetBlendMode(int index, QPainter::CompositionMode mode) {
+  layers_[index].blend_mode = mode;
+  RebuildCaches();
+}
+
+QImage LayerStack::Copy(const QRect &rect) const {
+  if (isNull()) {
+    return QImage();
+  }
+  return layers_[active_].image.Copy(rect);
+}
+
+QRect LayerStack::Draw(const QImage &image, const QRect &target, QPainter::CompositionMode mode) {
+  if (isNull()) {
+    return QRect();
+  }
+  if (sparse() && !rect().contains(target)) {
+    // Grows past the right and bottom edges. Only the bounds change, no
+    // tile is allocated or touched.
+    QSize grown = QSize(qMax(rect().right(), target.right()) + 1, qMax(rect().bottom(), target.bottom()) + 1);
+    for (Layer &layer : layers_) {
+      layer.image.Resize(grown);
+    }
+    below_.Resize(grown);
+    above_.Resize(grown);
+    composite_.Resize(grown);
+  }
+  layers_[active_].image.Draw(image, target, mode);
+  QRect dirty = target.intersected(rect());
+  Recomposite(dirty);
+  return dirty;
+}
+
+const TiledImage &LayerStack::composite() const {
+  return composite_;
+}
+
+QImage LayerStack::Flatten() const {
+  if (isNull()) {
+    return QImage();
+  }
+  if (sparse()) {
+    QRect used = composite_.UsedRect();
+    return used.isEmpty() ? composite_.Copy(QRect(0, 0, 1, 1)) : composite_.Copy(used);
+  }
+  if (layers_.size() == 1) {
+    return layers_[0].image.ToImage();
+  }
+  QImage flat = composite_.ToImage();
+  const TiledImage &bottom = layers_[0].image;
+  if (bottom.format() == QImage::Format_Indexed8) {
+    return flat.convertToFormat(QImage::Format_Indexed8, bottom.color_table());
+  }
+  return flat.convertToFormat(bottom.format());
+}
+
+TiledImage LayerStack::EmptyImage() const {
+  if (sparse()) {
+    return TiledImage::Sparse(layers_[0].image.size(), QImage::Format_ARGB32_Premultiplied);
+  }
+  TiledImage image(layers_[0].image.size(), QImage::Format_ARGB32_Premultiplied);
+  image.Fill(0);
+  return image;
+}
+
+QVector<QPoint> LayerStack::Tiles(int first, int last) const {
+  QVector<QPoint> tiles;
+  const TiledImage &bottom = layers_[0].image;
+  if (!sparse()) {
+    for (int row = 0; row < bottom.rows(); row++) {
+      for (int column = 0; column < bottom.columns(); column++) {
+        tiles.push_back(QPoint(column, row));
+      }
+    }
+    return tiles;
+  }
+  QSet<quint64> seen;
+  for (int i = first; i <= last; i++) {
+    for (const QPoint &p : layers_[i].image.tile_positions()) {
+      quint64 key = (quint64(quint32(p.y())) << 32) | quint32(p.x());
+      if (!seen.contains(key)) {
+        seen.insert(key);
+        tiles.push_back(p);
+      }
+    }
+  }
+  return tiles;
+}
+
+bool LayerStack::AnyTile(int first, int last, int column, int row) const {
+  for (int i = first; i <= last; i++) {
+    if (layers_[i].visible && layers_[i].image.HasTile(column, row)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LayerStack::MergeTile(QPainter *painter, int first, int last, int column, int row) const {
+  for (int i = first; i <= last; i++) {
+    DrawTile(painter, layers_[i], column, row);
+  }
+}
+
+void LayerStack::DropCaches() {
+  below_ = above_ = composite_ = TiledImage();
+}
+
+qint64 LayerStack::UnsharedBytes(QSet<const uchar *> *seen) const {
+  qint64 bytes = 0;
+  for (const Layer &layer : layers_) {
+    for (const QPoint &p : layer.image.tile_positions()) {
+      const QImage &tile = layer.image.tile(p.x(), p.y());
+      if (!seen->contains(tile.constBits())) {
+        seen->insert(tile.constBits());
+        bytes += tile.byteCount();
+      }
+    }
+  }
+  return bytes;
+}
+
+void LayerStack::RebuildCaches() {
+  if (isNull()) {
+    below_ = above_ = composite_ = TiledImage();
+    return;
+  }
+
+  above_merged_ = true;
+  for (int i = active_ + 1; i < layers_.size(); i++) {
+    if (layers_[i].visible && layers_[i].blend_mode != QPainter::CompositionMode_SourceOver) {
+      above_merged_ = false;
+    }
+  }
+
+  below_ = EmptyImage();
+  above_ = above_merged_ ? EmptyImage() : TiledImage();
+  composite_ = EmptyImage();
+  for (const QPoint &p : Tiles(0, layers_.size() - 1)) {
+    int column = p.x();
+    int row = p.y();
+    if (AnyTile(0, active_ - 1, column, row)) {
+      QImage below = below_.tile(column, row);
+      QPainter below_painter(&below);
+      MergeTile(&below_painter, 0, active_ - 1, column, row);
+      below_painter.end();
+      below_.SetTile(column, row, below);
+    }
+
+    if (above_merged_ && AnyTile(active_ + 1, layers_.size() - 1, column, row)) {
+      QImage above = above_.tile(column, row);
+      QPainter above_painter(&above);
+      MergeTile(&above_painter, active_ + 1, layers_.size() - 1, column, row);
+      above_painter.end();
+      above_.SetTile(column, row, above);
+    }
+
+    RecompositeTile(column, row);
+  }
+}
+
+void LayerStack::Recomposite(const QRect &rect) {
+  QRect r = rect.intersected(this->rect());
+  if (r.isEmpty()) {
+    return;
+  }
+  const int size = TiledImage::kTileSize;
+  for (int row = r.top() / size; row <= r.bottom() / size; row++) {
+    for (int column = r.left() / size; column <= r.right() / size; column++) {
+      RecompositeTile(column, row);
+    }
+  }
+}
+
+void LayerStack::RecompositeTile(int column, int row) {
+  if (sparse() && !AnyTile(0, layers_.size() - 1, column, row)) {
+    composite_.RemoveTile(column, row);
+    return;
+  }
+  // Under the active layer, the active layer, over the active layer.
+  QImage out = below_.tile(column, row).copy();
+  QPainter painter(&out);
+  DrawTile(&painter, layers_[active_], column, row);
+  if (above_merged_) {
+    painter.setOpacity(1.0);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    painter.drawImage(0, 0, above_.tile(column, row));
+  } else {
+    MergeTile(&painter, active_ + 1, layers_.size() - 1, column, row);
+  }
+  painter.end();
+  composite_.SetTile(column, row, out);
+}
+
+void LayerStack::Serialize(QDataStream *out) const {
+  *out << qint32(layers_.size()) << qint32(active_);
+  for (const Layer &layer : layers_) {
+    *out << layer.name << layer.visible << layer.opacity << qint32(layer.blend_mode);
+    layer.image.Serialize(out);
+  }
+}
+
+bool LayerStack::Deserialize(QDataStream *in) {
+  qint32 count;
+  qint32 active;
+  *in >> count >> active;
+  QVector<Layer> layers;
+  for (int i = 0; i < count && in->status() == QDataStream::Ok; i++) {
+    Layer layer;
+    qint32 blend_mode;
+    *in >> layer.name >> layer.visible >> layer.opacity >> blend_mode;
+    layer.blend_mode = QPainter::CompositionMode(blend_mode);
+    layer.image = TiledImage::Deserialize(in);
+    layers.push_back(layer);
+  }
+  if (in->status() != QDataStream::Ok || layers.isEmpty()) {
+    return false;
+  }
+  layers_ = layers;
+  active_ = qBound(0, int(active), layers_.size() - 1);
+  RebuildCaches();
+  return true;
+}
@@ -0,0 +1,126 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef LAYER_STACK_H
+#define LAYER_STACK_H
+
+#include <QColor>
+#include <QPainter>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "tiled_image.h"
+
+/*!
+ * \brief Ordered layers of a document and their flattened composite.
+ *
+ * Layer 0 is the bottom one. The visible layers under the active one are
+ * kept merged in one cached image, and so are the ones above it, so an edit
+ * of the active layer recomposites its dirty tiles from three images no
+ * matter how many layers the document has.
+ */
+class LayerStack {
+public:
+  class Layer {
+  public:
+    QString name;
+    TiledImage image;
+    bool visible;
+    qreal opacity;
+    QPainter::CompositionMode blend_mode;
+  };
+
+  LayerStack();
+
+  // Drops every layer and starts over with |image| as the only one.
+  void Reset(const QImage &image);
+  // Same, with an empty sparse layer that grows while it is drawn on.
+  void ResetSparse(const QSize &size);
+  // Crops or extends every layer, moving the pixels by |offset|. New bottom
+  // layer pixels take |fill|, they stay transparent on sparse documents.
+  void Resize(const QSize &size, const QPoint &offset, const QColor &fill);
+  // Scales every layer up by |factor| (2 or 4) with nearest neighbour,
+  // streaming tile by tile.
+  void Zoom(int factor);
+
+  bool isNull() const;
+  bool sparse() const;
+  QSize size() const;
+  QRect rect() const;
+
+  int count() const;
+  int active() const;
+  void set_active(int index);
+  const Layer &layer(int index) const;
+
+  // Adds a transparent layer over the active one and activates it.
+  void AddLayer(const QString &name);
+  // Removes a layer, the last one is never removed.
+  void RemoveLayer(int index);
+  void MoveLayer(int from, int to);
+  void SetName(int index, const QString &name);
+  void SetVisible(int index, bool visible);
+  void SetOpacity(int index, qreal opacity);
+  void SetBlendMode(int index, QPainter::CompositionMode mode);
+
+  // Reads and writes of the active layer. Draw returns the rect whose
+  // composite changed. Sparse documents grow to hold |target|.
+  QImage Copy(const QRect &rect) const;
+  QRect Draw(const QImage &image, const QRect &target, QPainter::CompositionMode mode);
+
+  const TiledImage &composite() const;
+  // Image to save: the only layer as it is, or the composite in the format
+  // of the bottom layer. Sparse documents are cropped to their used bounds.
+  QImage Flatten() const;
+
+  // Every layer with its settings, the caches are rebuilt on reading.
+  void Serialize(QDataStream *out) const;
+  bool Deserialize(QDataStream *in);
+
+  // A stack kept aside (in a history) needs only its layers. Drawing or
+  // reading the composite needs the caches rebuilt first.
+  void DropCaches();
+  void RebuildCaches();
+  // Bytes of the layer tiles whose pixels are not in |seen|, which gets them
+  // added. Tiles shared between stacks count once.
+  qint64 UnsharedBytes(QSet<const uchar *> *seen) const;
+
+private:
+  QVector<Layer> layers_;
+  int active_;
+
+  TiledImage below_;
+  TiledImage above_;
+  // Above layers are only merged ahead when all of them blend normally, other
+  // modes don't associate and are drawn one by one.
+  bool above_merged_;
+  TiledImage composite_;
+
+  void Recomposite(const QRect &rect);
+  void RecompositeTile(int column, int row);
+  // Tiles to visit when merging layers |first| to |last|: all of them, or
+  // only the allocated ones on sparse documents.
+  QVector<QPoint> Tiles(int first, int last) const;
+  bool AnyTile(int first, int last, int column, int row) const;
+  void MergeTile(QPainter *painter, int first, int last, int column, int row) const;
+  TiledImage EmptyImage() const;
+};
+
+#endif // LAYER_STACK_H
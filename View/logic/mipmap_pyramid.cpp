@@ -0,0 +1,137 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "mipmap_pyramid.h"
+
+#include "utils/debug.h"
+
+// Levels are not reduced below this size on the largest side.
+const int kMinLevelSize = 8;
+
+namespace {
+// Rounded average of four ARGB32 pixels, two channels at a time.
+inline QRgb Average4(QRgb a, QRgb b, QRgb c, QRgb d) {
+  quint32 rb = (a & 0xff00ff) + (b & 0xff00ff) + (c & 0xff00ff) + (d & 0xff00ff) + 0x20002;
+  quint32 ag = ((a >> 8) & 0xff00ff) + ((b >> 8) & 0xff00ff) + ((c >> 8) & 0xff00ff) + ((d >> 8) & 0xff00ff) + 0x20002;
+  return ((rb >> 2) & 0xff00ff) | (((ag >> 2) & 0xff00ff) << 8);
+}
+}
+
+MipmapPyramid::MipmapPyramid() {
+}
+
+void MipmapPyramid::Build(const QImage &source) {
+  levels_.clear();
+  source_size_ = source.size();
+  if (source.isNull()) {
+    return;
+  }
+
+  QSize size = source.size();
+  while (qMax(size.width(), size.height()) > kMinLevelSize) {
+    size = QSize(qMax(1, (size.width() + 1) / 2), qMax(1, (size.height() + 1) / 2));
+    levels_.push_back(QImage(size, QImage::Format_ARGB32_Premultiplied));
+  }
+  Update(source, source.rect());
+}
+
+void MipmapPyramid::Update(const QImage &source, const QRect &dirty) {
+  Update(source, QPoint(0, 0), dirty);
+}
+
+void MipmapPyramid::Update(const QImage &region, const QPoint &origin, const QRect &dirty) {
+  if (levels_.isEmpty()) {
+    return;
+  }
+  QRect read_rect = ReadRect(dirty);
+  if (read_rect.isEmpty()) {
+    return;
+  }
+
+  // Level 1 reads straight from the source. Only the dirty region is
+  // converted when the source is not in the pyramid format.
+  QRect dst_rect = ParentRect(read_rect);
+  if (region.format() == QImage::Format_ARGB32_Premultiplied) {
+    Downsample(region, origin, &levels_[0], dst_rect);
+  } else {
+    QImage converted = region.copy(read_rect.translated(-origin)).convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    Downsample(converted, read_rect.topLeft(), &levels_[0], dst_rect);
+  }
+
+  for (int i = 1; i < levels_.size(); i++) {
+    dst_rect = ParentRect(dst_rect);
+    Downsample(levels_[i - 1], QPoint(0, 0), &levels_[i], dst_rect);
+  }
+}
+
+QRect MipmapPyramid::ReadRect(const QRect &dirty) const {
+  QRect source_rect(QPoint(0, 0), source_size_);
+  QRect src_rect = dirty.intersected(source_rect);
+  if (src_rect.isEmpty()) {
+    return QRect();
+  }
+  QRect dst_rect = ParentRect(src_rect);
+  return QRect(dst_rect.topLeft() * 2, dst_rect.size() * 2).intersected(source_rect);
+}
+
+void MipmapPyramid::Clear() {
+  source_size_ = QSize();
+  levels_.clear();
+}
+
+int MipmapPyramid::levels() const {
+  return levels_.size() + 1;
+}
+
+const QImage &MipmapPyramid::level(int i) const {
+  return levels_[i - 1];
+}
+
+int MipmapPyramid::LevelForScale(qreal scale) const {
+  int level = 0;
+  qreal level_scale = 0.5;
+  while (level < levels_.size() && level_scale >= scale) {
+    level++;
+    level_scale *= 0.5;
+  }
+  return level;
+}
+
+void MipmapPyramid::Downsample(const QImage &src, const QPoint &src_origin, QImage *dst, const QRect &dst_rect) {
+  QRect rect = dst_rect.intersected(dst->rect());
+  const int last_x = src_origin.x() + src.width() - 1;
+  const int last_y = src_origin.y() + src.height() - 1;
+
+  for (int y = rect.top(); y <= rect.bottom(); y++) {
+    int y0 = 2 * y - src_origin.y();
+    int y1 = qMin(2 * y + 1, last_y) - src_origin.y();
+    const QRgb *row0 = reinterpret_cast<const QRgb *>(src.constScanLine(y0));
+    const QRgb *row1 = reinterpret_cast<const QRgb *>(src.constScanLine(y1));
+    QRgb *out = reinterpret_cast<QRgb *>(dst->scanLine(y));
+    for (int x = rect.left(); x <= rect.right(); x++) {
+      int x0 = 2 * x - src_origin.x();
+      int x1 = qMin(2 * x + 1, last_x) - src_origin.x();
+      out[x] = Average4(row0[x0], row0[x1], row1[x0], row1[x1]);
+    }
+  }
+}
+
+QRect MipmapPyramid::ParentRect(const QRect &rect) {
+  return QRect(QPoint(rect.left() / 2, rect.top() / 2), QPoint(rect.right() / 2, rect.bottom() / 2));
+}
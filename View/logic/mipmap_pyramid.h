@@ -0,0 +1,61 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef MIPMAP_PYRAMID_H
+#define MIPMAP_PYRAMID_H
+
+#include <QImage>
+#include <QVector>
+
+/*!
+ * \brief Chain of half-size reductions of an image.
+ *
+ * Level 0 is the source itself and is not stored; level i has the size of the
+ * source divided by 2^i. Updating a dirty rect only recomputes the pixels
+ * above it on each level.
+ */
+class MipmapPyramid {
+public:
+  MipmapPyramid();
+
+  void Build(const QImage &source);
+  void Update(const QImage &source, const QRect &dirty);
+  // Same as above, with |region| holding the source pixels placed at |origin|.
+  // The region must cover ReadRect(dirty).
+  void Update(const QImage &region, const QPoint &origin, const QRect &dirty);
+  // Source pixels read by an update of |dirty|.
+  QRect ReadRect(const QRect &dirty) const;
+  void Clear();
+
+  // Number of levels, including the source level 0.
+  int levels() const;
+  // Level i >= 1. Level 0 must be taken from the source image.
+  const QImage &level(int i) const;
+  // The smallest level that still has at least |scale| of the source size.
+  int LevelForScale(qreal scale) const;
+
+private:
+  QSize source_size_;
+  QVector<QImage> levels_;
+
+  static void Downsample(const QImage &src, const QPoint &src_origin, QImage *dst, const QRect &dst_rect);
+  static QRect ParentRect(const QRect &rect);
+};
+
+#endif // MIPMAP_PYRAMID_H
@@ -0,0 +1,39 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "pixel_format.h"
+
+namespace PixelFormat {
+
+QImage::Format Canonical(const QImage &image) {
+  return image.format() == QImage::Format_Indexed8 ? QImage::Format_Indexed8 : kTrueColor;
+}
+
+QImage ToCanonical(const QImage &image) {
+  // Same format returns a shallow copy.
+  return image.convertToFormat(Canonical(image));
+}
+
+QImage ForSaving(const QImage &image) {
+  if (image.format() == QImage::Format_Indexed8) {
+    return image;
+  }
+  return image.convertToFormat(QImage::Format_ARGB32);
+}
+}
@@ -0,0 +1,44 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <QImage>
+
+/*!
+ * \brief The pixel formats documents are kept in.
+ *
+ * True color documents are premultiplied ARGB, what QPainter draws without
+ * converting, and 8 bit indexed ones keep their palette. Images are brought
+ * to it once when they are loaded and taken out of it once when saved, so
+ * the canvas, the editor and the undo history pass pixels around as they
+ * are.
+ */
+namespace PixelFormat {
+const QImage::Format kTrueColor = QImage::Format_ARGB32_Premultiplied;
+
+// The format a document made from |image| is kept in.
+QImage::Format Canonical(const QImage &image);
+QImage ToCanonical(const QImage &image);
+// Straight alpha for the image writers, indexed images as they are.
+QImage ForSaving(const QImage &image);
+}
+
+#endif // PIXEL_FORMAT_H
@@ -0,0 +1,97 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "shadow_effect.h"
+
+#include <QPainter>
+#include <QVector>
+#include <QtConcurrent>
+
+#include "logic/bit_mask.h"
+#include "logic/indexed_color.h"
+#include "logic/layer_stack.h"
+
+namespace {
+struct Cell {
+  QRect rect;
+  QImage image;
+  bool changed;
+};
+}
+
+namespace ShadowEffect {
+
+bool Apply(QImage *image, const QPoint &offset, int radius, const QColor &color, const BitMask *mask) {
+  BitMask opaque = BitMask::FromAlpha(*image);
+  if (opaque.IsEmpty()) {
+    return false;
+  }
+  BitMask shadow = opaque;
+  shadow.Dilate(radius);
+  shadow.Translate(offset);
+  shadow.Subtract(opaque);
+  if (nullptr != mask && mask->size() == shadow.size()) {
+    shadow.Subtract(*mask);
+  }
+
+  if (image->format() == QImage::Format_Indexed8) {
+    // No painter on indexed images, the shadow only covers transparent
+    // pixels anyway.
+    uint value = IndexedColor::PixelValue(*image, color);
+    for (int y = 0; y < image->height(); y++) {
+      for (int x = 0; x < image->width(); x++) {
+        if (shadow.test(x, y)) {
+          image->setPixel(x, y, value);
+        }
+      }
+    }
+    return true;
+  }
+  QPainter painter(image);
+  painter.setCompositionMode(QPainter::CompositionMode_DestinationOver);
+  painter.drawImage(0, 0, shadow.ToImage(color.rgba()));
+  return true;
+}
+
+QRect ApplyToCells(LayerStack *layers, const QSize &cell, const QPoint &offset, int radius, const QColor &color) {
+  if (layers->isNull() || cell.isEmpty()) {
+    return QRect();
+  }
+  QRect dirty;
+  // One row of cells at a time, so only that row is copied out.
+  for (int top = 0; top < layers->size().height(); top += cell.height()) {
+    QVector<Cell> cells;
+    for (int left = 0; left < layers->size().width(); left += cell.width()) {
+      Cell c = {QRect(QPoint(left, top), cell).intersected(layers->rect()), QImage(), false};
+      cells.push_back(c);
+    }
+    // Copy only reads the layer, writing back is left to this thread.
+    QtConcurrent::blockingMap(cells, [&](Cell &c) {
+      c.image = layers->Copy(c.rect);
+      c.changed = Apply(&c.image, offset, radius, color);
+    });
+    for (const Cell &c : cells) {
+      if (c.changed) {
+        dirty |= layers->Draw(c.image, c.rect, QPainter::CompositionMode_Source);
+      }
+    }
+  }
+  return dirty;
+}
+}
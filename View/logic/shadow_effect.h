@@ -0,0 +1,48 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef SHADOW_EFFECT_H
+#define SHADOW_EFFECT_H
+
+#include <QColor>
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+
+class BitMask;
+class LayerStack;
+
+/*!
+ * \brief Drop shadows and outlines made from the alpha of the pixels.
+ *
+ * The opaque pixels are packed into a BitMask, grown by the radius, moved by
+ * the offset, and |color| goes where the result lands on fully transparent
+ * pixels. A zero offset with a radius of 1 outlines the pixels.
+ */
+namespace ShadowEffect {
+// Returns false when |image| has no opaque pixel and was left alone. Pixels
+// set in |mask| are not painted.
+bool Apply(QImage *image, const QPoint &offset, int radius, const QColor &color, const BitMask *mask = nullptr);
+// Applies the effect to every |cell| sized cell of the active layer on its
+// own, so sprites of a sheet don't shadow their neighbours. Cells are
+// processed in parallel. Returns the rect that changed.
+QRect ApplyToCells(LayerStack *layers, const QSize &cell, const QPoint &offset, int radius, const QColor &color);
+}
+
+#endif // SHADOW_EFFECT_H
@@ -0,0 +1,607 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "tiled_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "indexed_color.h"
+#include "pixel_format.h"
+#include "utils/debug.h"
+
+namespace {
+// Copies the |rect| area (in |src| coordinates) into |dst| at |dst_pos|.
+// Both images must share the same pixel format.
+void CopyPixels(const QImage &src, const QRect &rect, QImage *dst, const QPoint &dst_pos) {
+  const int bytes_per_pixel = src.depth() / 8;
+  const int row_bytes = rect.width() * bytes_per_pixel;
+  for (int y = 0; y < rect.height(); y++) {
+    const uchar *in = src.constScanLine(rect.y() + y) + rect.x() * bytes_per_pixel;
+    uchar *out = dst->scanLine(dst_pos.y() + y) + dst_pos.x() * bytes_per_pixel;
+    std::memcpy(out, in, row_bytes);
+  }
+}
+
+bool SamePixels(const QImage &a, const QRect &rect, const QImage &b) {
+  const int row_bytes = rect.width() * (a.depth() / 8);
+  const int offset = rect.x() * (a.depth() / 8);
+  for (int y = 0; y < rect.height(); y++) {
+    if (std::memcmp(a.constScanLine(rect.y() + y) + offset, b.constScanLine(y), row_bytes) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes every pixel of |rect| in |src| |factor| times in both directions,
+// starting at the origin of |dst|.
+void ZoomPixels(const QImage &src, const QRect &rect, int factor, QImage *dst) {
+  const int bytes_per_pixel = src.depth() / 8;
+  const int row_bytes = rect.width() * factor * bytes_per_pixel;
+  for (int y = 0; y < rect.height(); y++) {
+    const uchar *in = src.constScanLine(rect.y() + y) + rect.x() * bytes_per_pixel;
+    uchar *out = dst->scanLine(y * factor);
+    for (int x = 0; x < rect.width(); x++) {
+      for (int i = 0; i < factor; i++) {
+        std::memcpy(out + (x * factor + i) * bytes_per_pixel, in + x * bytes_per_pixel, bytes_per_pixel);
+      }
+    }
+    for (int i = 1; i < factor; i++) {
+      std::memcpy(dst->scanLine(y * factor + i), out, row_bytes);
+    }
+  }
+}
+
+// Sets |count| pixels from |line| on to |pixel|.
+void FillSpan(uchar *line, int count, int bytes_per_pixel, uint pixel) {
+  if (bytes_per_pixel == 1) {
+    std::memset(line, int(pixel), count);
+  } else if (bytes_per_pixel == 4) {
+    std::fill_n(reinterpret_cast<quint32 *>(line), count, quint32(pixel));
+  } else {
+    for (int x = 0; x < count; x++) {
+      std::memcpy(line + x * bytes_per_pixel, &pixel, bytes_per_pixel);
+    }
+  }
+}
+
+// Fills the pixels of |dst| outside of |keep|, row by row.
+void FillOutside(QImage *dst, const QRect &keep, uint pixel) {
+  const int bytes_per_pixel = dst->depth() / 8;
+  const int width = dst->width();
+  for (int y = 0; y < dst->height(); y++) {
+    uchar *line = dst->scanLine(y);
+    if (keep.isEmpty() || y < keep.top() || y > keep.bottom()) {
+      FillSpan(line, width, bytes_per_pixel, pixel);
+      continue;
+    }
+    FillSpan(line, keep.left(), bytes_per_pixel, pixel);
+    FillSpan(line + (keep.right() + 1) * bytes_per_pixel, width - keep.right() - 1, bytes_per_pixel, pixel);
+  }
+}
+
+// Tiles copy raw rows, so sub-byte formats are widened first.
+QImage TileableImage(const QImage &image) {
+  if (image.depth() < 8) {
+    return image.convertToFormat(PixelFormat::kTrueColor);
+  }
+  return image;
+}
+}
+
+TiledImage::TiledImage() : format_(QImage::Format_Invalid),
+                           columns_(0),
+                           rows_(0),
+                           sparse_(false) {
+}
+
+TiledImage::TiledImage(const QImage &image) : format_(QImage::Format_Invalid),
+                                              columns_(0),
+                                              rows_(0),
+                                              sparse_(false) {
+  if (image.isNull()) {
+    return;
+  }
+  QImage source = TileableImage(image);
+  Allocate(source.size(), source.format());
+  color_table_ = source.colorTable();
+  for (int row = 0; row < rows_; row++) {
+    for (int column = 0; column < columns_; column++) {
+      tiles_.insert(Key(column, row), source.copy(TileRect(column, row)));
+    }
+  }
+}
+
+TiledImage::TiledImage(const QSize &size, QImage::Format format, const QVector<QRgb> &color_table) : format_(QImage::Format_Invalid),
+                                                                                                     columns_(0),
+                                                                                                     rows_(0),
+                                                                                                     sparse_(false) {
+  Allocate(size, format);
+  color_table_ = color_table;
+  for (int row = 0; row < rows_; row++) {
+    for (int column = 0; column < columns_; column++) {
+      QImage t(TileRect(column, row).size(), format_);
+      if (!color_table_.isEmpty()) {
+        t.setColorTable(color_table_);
+      }
+      tiles_.insert(Key(column, row), t);
+    }
+  }
+}
+
+TiledImage TiledImage::Sparse(const QSize &size, QImage::Format format) {
+  TiledImage image;
+  image.sparse_ = true;
+  image.Allocate(size, format);
+  image.empty_tile_ = QImage(kTileSize, kTileSize, format);
+  image.empty_tile_.fill(0);
+  return image;
+}
+
+quint64 TiledImage::Key(int column, int row) {
+  return (quint64(quint32(row)) << 32) | quint32(column);
+}
+
+void TiledImage::Allocate(const QSize &size, QImage::Format format) {
+  size_ = size;
+  format_ = format;
+  columns_ = (size.width() + kTileSize - 1) / kTileSize;
+  rows_ = (size.height() + kTileSize - 1) / kTileSize;
+}
+
+bool TiledImage::isNull() const {
+  return format_ == QImage::Format_Invalid || size_.isEmpty();
+}
+
+QSize TiledImage::size() const {
+  return size_;
+}
+
+QRect TiledImage::rect() const {
+  return QRect(QPoint(0, 0), size_);
+}
+
+QImage::Format TiledImage::format() const {
+  return format_;
+}
+
+QVector<QRgb> TiledImage::color_table() const {
+  return color_table_;
+}
+
+bool TiledImage::sparse() const {
+  return sparse_;
+}
+
+int TiledImage::columns() const {
+  return columns_;
+}
+
+int TiledImage::rows() const {
+  return rows_;
+}
+
+QRect TiledImage::TileRect(int column, int row) const {
+  QRect r(column * kTileSize, row * kTileSize, kTileSize, kTileSize);
+  return sparse_ ? r : r.intersected(rect());
+}
+
+const QImage &TiledImage::tile(int column, int row) const {
+  auto it = tiles_.constFind(Key(column, row));
+  return it == tiles_.constEnd() ? empty_tile_ : it.value();
+}
+
+bool TiledImage::HasTile(int column, int row) const {
+  return tiles_.contains(Key(column, row));
+}
+
+QVector<QPoint> TiledImage::tile_positions() const {
+  QVector<QPoint> positions;
+  positions.reserve(tiles_.size());
+  for (auto it = tiles_.constBegin(); it != tiles_.constEnd(); ++it) {
+    positions.push_back(QPoint(int(quint32(it.key())), int(it.key() >> 32)));
+  }
+  return positions;
+}
+
+void TiledImage::SetTile(int column, int row, const QImage &image) {
+  tiles_.insert(Key(column, row), image);
+}
+
+void TiledImage::RemoveTile(int column, int row) {
+  tiles_.remove(Key(column, row));
+}
+
+QImage &TiledImage::MutableTile(int column, int row) {
+  auto it = tiles_.find(Key(column, row));
+  if (it == tiles_.end()) {
+    // Shares the empty tile until the caller writes to it.
+    it = tiles_.insert(Key(column, row), empty_tile_);
+  }
+  return it.value();
+}
+
+QRect TiledImage::TileSpan(const QRect &rect) const {
+  QRect r = rect.intersected(this->rect());
+  if (r.isEmpty()) {
+    return QRect();
+  }
+  return QRect(QPoint(r.left() / kTileSize, r.top() / kTileSize),
+               QPoint(r.right() / kTileSize, r.bottom() / kTileSize));
+}
+
+QImage TiledImage::ToImage() const {
+  return Copy(rect());
+}
+
+QImage TiledImage::Copy(const QRect &rect) const {
+  if (isNull() || rect.isEmpty()) {
+    return QImage();
+  }
+  QImage out(rect.size(), format_);
+  if (!color_table_.isEmpty()) {
+    out.setColorTable(color_table_);
+  }
+  if (sparse_ || !this->rect().contains(rect)) {
+    out.fill(0);
+  }
+
+  QRect span = TileSpan(rect);
+  for (int row = span.top(); row <= span.bottom(); row++) {
+    for (int column = span.left(); column <= span.right(); column++) {
+      if (!HasTile(column, row)) {
+        continue;
+      }
+      QRect tile_rect = TileRect(column, row);
+      QRect part = tile_rect.intersected(rect).intersected(this->rect());
+      CopyPixels(tile(column, row), part.translated(-tile_rect.topLeft()), &out, part.topLeft() - rect.topLeft());
+    }
+  }
+  return out;
+}
+
+void TiledImage::Write(const QImage &image, const QPoint &pos) {
+  if (isNull() || image.isNull()) {
+    return;
+  }
+  DEBUG_CONVERSION(image, format_);
+  QImage source = image.format() == format_ ? image : image.convertToFormat(format_, color_table_);
+  QRect target = QRect(pos, source.size());
+
+  QRect span = TileSpan(target);
+  for (int row = span.top(); row <= span.bottom(); row++) {
+    for (int column = span.left(); column <= span.right(); column++) {
+      QRect tile_rect = TileRect(column, row);
+      QRect part = tile_rect.intersected(target);
+      CopyPixels(source, part.translated(-pos), &MutableTile(column, row), part.topLeft() - tile_rect.topLeft());
+    }
+  }
+}
+
+void TiledImage::Draw(const QImage &image, const QRect &target, QPainter::CompositionMode mode) {
+  if (isNull() || image.isNull()) {
+    return;
+  }
+  if (format_ == QImage::Format_Indexed8) {
+    DrawIndexed(image, target, mode);
+    return;
+  }
+  DEBUG_CONVERSION(image, format_);
+  QRect span = TileSpan(target);
+  for (int row = span.top(); row <= span.bottom(); row++) {
+    for (int column = span.left(); column <= span.right(); column++) {
+      QRect tile_rect = TileRect(column, row);
+      QPainter painter(&MutableTile(column, row));
+      painter.setCompositionMode(mode);
+      painter.drawImage(target.translated(-tile_rect.topLeft()), image);
+    }
+  }
+}
+
+void TiledImage::DrawIndexed(const QImage &image, const QRect &target, QPainter::CompositionMode mode) {
+  QImage source = image.size() == target.size() ? image : image.scaled(target.size());
+  bool replace = mode == QPainter::CompositionMode_Source;
+  if (replace && source.format() == QImage::Format_Indexed8 && source.colorTable() == color_table_) {
+    Write(source, target.topLeft());
+    return;
+  }
+
+  // QPainter can't draw on indexed tiles, colors are mapped to the palette.
+  IndexedColor::IndexMapper mapper(color_table_);
+  QRect span = TileSpan(target);
+  for (int row = span.top(); row <= span.bottom(); row++) {
+    for (int column = span.left(); column <= span.right(); column++) {
+      QRect tile_rect = TileRect(column, row);
+      QRect part = tile_rect.intersected(target);
+      QImage &t = MutableTile(column, row);
+      for (int y = part.top(); y <= part.bottom(); y++) {
+        uchar *out = t.scanLine(y - tile_rect.top());
+        for (int x = part.left(); x <= part.right(); x++) {
+          QRgb c = source.pixel(x - target.left(), y - target.top());
+          if (replace || qAlpha(c) != 0) {
+            out[x - tile_rect.left()] = mapper.Map(c);
+          }
+        }
+      }
+    }
+  }
+}
+
+void TiledImage::Fill(uint pixel) {
+  if (sparse_ && pixel == 0) {
+    tiles_.clear();
+    return;
+  }
+  for (int row = 0; row < rows_; row++) {
+    for (int column = 0; column < columns_; column++) {
+      MutableTile(column, row).fill(pixel);
+    }
+  }
+}
+
+void TiledImage::Resize(const QSize &size) {
+  if (!sparse_) {
+    return;
+  }
+  QRect bounds(QPoint(0, 0), size);
+  Allocate(size, format_);
+  for (auto it = tiles_.begin(); it != tiles_.end();) {
+    int column = int(quint32(it.key()));
+    int row = int(it.key() >> 32);
+    QRect tile_rect = TileRect(column, row);
+    if (!bounds.intersects(tile_rect)) {
+      it = tiles_.erase(it);
+      continue;
+    }
+    if (!bounds.contains(tile_rect)) {
+      // Clear what was cut off, so growing again shows it transparent.
+      QRect keep = bounds.intersected(tile_rect).translated(-tile_rect.topLeft());
+      QImage &t = it.value();
+      QImage kept = t.copy(keep);
+      t.fill(0);
+      CopyPixels(kept, kept.rect(), &t, keep.topLeft());
+    }
+    ++it;
+  }
+}
+
+TiledImage TiledImage::Resized(const QSize &size, const QPoint &offset, uint fill) const {
+  if (isNull()) {
+    return TiledImage();
+  }
+  TiledImage out = sparse_ ? Sparse(size, format_) : TiledImage();
+  if (sparse_) {
+    fill = 0;
+  } else {
+    out.Allocate(size, format_);
+  }
+  out.color_table_ = color_table_;
+
+  const QRect moved = rect().translated(offset);
+  const bool aligned = offset.x() % kTileSize == 0 && offset.y() % kTileSize == 0;
+  // Tiles left with no pixels share one filled tile.
+  QImage filled;
+  for (int row = 0; row < out.rows_; row++) {
+    for (int column = 0; column < out.columns_; column++) {
+      QRect tile_rect = out.TileRect(column, row);
+      QRect overlap = tile_rect.intersected(moved);
+      QRect source = overlap.translated(-offset);
+      QRect span = TileSpan(source);
+      if (aligned && overlap == tile_rect && span.size() == QSize(1, 1) &&
+          TileRect(span.left(), span.top()) == source) {
+        if (HasTile(span.left(), span.top())) {
+          out.tiles_.insert(Key(column, row), tile(span.left(), span.top()));
+        }
+        continue;
+      }
+
+      bool stored = false;
+      for (int r = span.top(); r <= span.bottom(); r++) {
+        for (int c = span.left(); c <= span.right(); c++) {
+          stored |= HasTile(c, r);
+        }
+      }
+      if (!stored && sparse_) {
+        continue;
+      }
+      bool whole = tile_rect.size() == QSize(kTileSize, kTileSize);
+      if (!stored && whole && !filled.isNull()) {
+        out.tiles_.insert(Key(column, row), filled);
+        continue;
+      }
+
+      QImage t(tile_rect.size(), format_);
+      if (!color_table_.isEmpty()) {
+        t.setColorTable(color_table_);
+      }
+      if (!stored) {
+        t.fill(fill);
+        if (whole) {
+          filled = t;
+        }
+        out.tiles_.insert(Key(column, row), t);
+        continue;
+      }
+      // Missing tiles of a sparse source read transparent, clear it all.
+      FillOutside(&t, sparse_ ? QRect() : overlap.translated(-tile_rect.topLeft()), fill);
+      for (int r = span.top(); r <= span.bottom(); r++) {
+        for (int c = span.left(); c <= span.right(); c++) {
+          if (!HasTile(c, r)) {
+            continue;
+          }
+          QRect source_tile = TileRect(c, r);
+          QRect part = source_tile.intersected(source);
+          CopyPixels(tile(c, r), part.translated(-source_tile.topLeft()), &t, part.topLeft() + offset - tile_rect.topLeft());
+        }
+      }
+      out.tiles_.insert(Key(column, row), t);
+    }
+  }
+  return out;
+}
+
+QRect TiledImage::UsedRect() const {
+  QRect used;
+  for (auto it = tiles_.constBegin(); it != tiles_.constEnd(); ++it) {
+    QRect tile_rect = TileRect(int(quint32(it.key())), int(it.key() >> 32)).intersected(rect());
+    const QImage &t = it.value();
+    if (t.depth() != 32) {
+      used = used.united(tile_rect);
+      continue;
+    }
+    int left = tile_rect.width();
+    int right = -1;
+    int top = -1;
+    int bottom = -1;
+    for (int y = 0; y < tile_rect.height(); y++) {
+      const quint32 *line = reinterpret_cast<const quint32 *>(t.constScanLine(y));
+      for (int x = 0; x < tile_rect.width(); x++) {
+        if (line[x] != 0) {
+          left = qMin(left, x);
+          right = qMax(right, x);
+          top = top < 0 ? y : top;
+          bottom = y;
+        }
+      }
+    }
+    if (right >= 0) {
+      used = used.united(QRect(QPoint(left, top), QPoint(right, bottom)).translated(tile_rect.topLeft()));
+    }
+  }
+  return used;
+}
+
+void TiledImage::Zoom(int factor) {
+  if (isNull() || factor < 2 || kTileSize % factor != 0) {
+    return;
+  }
+  QHash<quint64, QImage> source;
+  source.swap(tiles_);
+  const int source_columns = columns_;
+  const int source_rows = rows_;
+  Allocate(size_ * factor, format_);
+
+  // Every source tile covers exactly |factor| x |factor| new tiles.
+  const int part = kTileSize / factor;
+  for (int row = 0; row < source_rows; row++) {
+    for (int column = 0; column < source_columns; column++) {
+      QImage tile = source.take(Key(column, row));
+      if (tile.isNull()) {
+        continue;
+      }
+      for (int j = 0; j < factor; j++) {
+        for (int i = 0; i < factor; i++) {
+          int new_column = column * factor + i;
+          int new_row = row * factor + j;
+          if (new_column >= columns_ || new_row >= rows_) {
+            continue;
+          }
+          QRect target = TileRect(new_column, new_row);
+          QImage zoomed(target.size(), format_);
+          if (!color_table_.isEmpty()) {
+            zoomed.setColorTable(color_table_);
+          }
+          ZoomPixels(tile, QRect(i * part, j * part, target.width() / factor, target.height() / factor), factor, &zoomed);
+          tiles_.insert(Key(new_column, new_row), zoomed);
+        }
+      }
+    }
+  }
+}
+
+TiledImage TiledImage::Updated(const QImage &image) const {
+  return Updated(image, rect());
+}
+
+TiledImage TiledImage::Updated(const QImage &image, const QRect &dirty) const {
+  if (isNull() || image.size() != size_ || image.format() != format_) {
+    return TiledImage(image);
+  }
+
+  TiledImage out = *this;
+  out.color_table_ = image.colorTable();
+  QRect span = TileSpan(dirty);
+  for (int row = span.top(); row <= span.bottom(); row++) {
+    for (int column = span.left(); column <= span.right(); column++) {
+      QRect tile_rect = TileRect(column, row);
+      if (!SamePixels(image, tile_rect, tile(column, row))) {
+        out.tiles_.insert(Key(column, row), image.copy(tile_rect));
+      }
+    }
+  }
+  return out;
+}
+
+void TiledImage::Restore(const TiledImage &current, QImage *image) const {
+  if (isNull() || current.size_ != size_ || current.format_ != format_ || image->size() != size_ ||
+      image->format() != format_) {
+    *image = ToImage();
+    return;
+  }
+
+  if (!color_table_.isEmpty()) {
+    image->setColorTable(color_table_);
+  }
+  for (int row = 0; row < rows_; row++) {
+    for (int column = 0; column < columns_; column++) {
+      const QImage &t = tile(column, row);
+      if (t.constBits() != current.tile(column, row).constBits()) {
+        CopyPixels(t, t.rect(), image, TileRect(column, row).topLeft());
+      }
+    }
+  }
+}
+
+void TiledImage::Serialize(QDataStream *out) const {
+  *out << size_ << qint32(format_) << color_table_ << sparse_ << qint32(tiles_.size());
+  for (auto it = tiles_.constBegin(); it != tiles_.constEnd(); ++it) {
+    const QImage &t = it.value();
+    *out << it.key();
+    out->writeRawData(reinterpret_cast<const char *>(t.constBits()), t.byteCount());
+  }
+}
+
+TiledImage TiledImage::Deserialize(QDataStream *in) {
+  QSize size;
+  qint32 format;
+  QVector<QRgb> color_table;
+  bool sparse;
+  qint32 count;
+  *in >> size >> format >> color_table >> sparse >> count;
+
+  TiledImage image;
+  if (sparse) {
+    image = Sparse(size, QImage::Format(format));
+  } else {
+    image.Allocate(size, QImage::Format(format));
+  }
+  image.color_table_ = color_table;
+  for (int i = 0; i < count && in->status() == QDataStream::Ok; i++) {
+    quint64 key;
+    *in >> key;
+    QImage t(image.TileRect(int(quint32(key)), int(key >> 32)).size(), image.format_);
+    if (!color_table.isEmpty()) {
+      t.setColorTable(color_table);
+    }
+    in->readRawData(reinterpret_cast<char *>(t.bits()), t.byteCount());
+    image.tiles_.insert(key, t);
+  }
+  return image;
+}
@@ -0,0 +1,128 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef TILED_IMAGE_H
+#define TILED_IMAGE_H
+
+#include <QDataStream>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+
+/*!
+ * \brief Image stored as a grid of fixed size tiles.
+ *
+ * Every tile is an implicitly shared QImage, so copying a TiledImage only
+ * copies tile handles, and a write detaches just the tiles it touches.
+ *
+ * A sparse image only stores the tiles that were written to, the others read
+ * as transparent. Its tiles are always whole, so it can be resized without
+ * touching them.
+ */
+class TiledImage {
+public:
+  static const int kTileSize = 64;
+
+  TiledImage();
+  explicit TiledImage(const QImage &image);
+  TiledImage(const QSize &size, QImage::Format format, const QVector<QRgb> &color_table = QVector<QRgb>());
+  static TiledImage Sparse(const QSize &size, QImage::Format format);
+
+  bool isNull() const;
+  QSize size() const;
+  QRect rect() const;
+  QImage::Format format() const;
+  QVector<QRgb> color_table() const;
+  bool sparse() const;
+
+  int columns() const;
+  int rows() const;
+  QRect TileRect(int column, int row) const;
+  // Missing tiles of a sparse image read as a shared transparent tile.
+  const QImage &tile(int column, int row) const;
+  bool HasTile(int column, int row) const;
+  // Column and row of every stored tile.
+  QVector<QPoint> tile_positions() const;
+  // Replaces a whole tile, |image| must have the TileRect size and format.
+  void SetTile(int column, int row, const QImage &image);
+  void RemoveTile(int column, int row);
+
+  // Materializes the whole image or a part of it. Pixels outside the image
+  // are transparent, like QImage::copy.
+  QImage ToImage() const;
+  QImage Copy(const QRect &rect) const;
+
+  // Copies |image| pixels to |pos|, detaching only the overlapped tiles.
+  void Write(const QImage &image, const QPoint &pos);
+  // QPainter::drawImage(target, image) restricted to the overlapped tiles.
+  // On Indexed8 images colors are mapped to the nearest palette entry.
+  void Draw(const QImage &image, const QRect &target, QPainter::CompositionMode mode);
+  void Fill(uint pixel);
+
+  // Sparse images only. Tiles left outside are dropped, growing allocates
+  // nothing.
+  void Resize(const QSize &size);
+  // Canvas resize: a |size| image with these pixels moved by |offset| and
+  // |fill| where none land (transparent on sparse images). Rows are copied
+  // in the native format and only the uncovered border is filled. Tiles that
+  // land whole on a tile of the result are shared.
+  TiledImage Resized(const QSize &size, const QPoint &offset, uint fill) const;
+  // Bounds of the non transparent pixels.
+  QRect UsedRect() const;
+
+  // Scales up by |factor| (2 or 4) with nearest neighbour, one source tile at
+  // a time. Each source tile is released once its pixels are written, so the
+  // old and the new tiles are never both held in full.
+  void Zoom(int factor);
+
+  // Returns a TiledImage with the contents of |image| that shares every tile
+  // whose pixels did not change with this one.
+  TiledImage Updated(const QImage &image) const;
+  // Same, but only the tiles |dirty| overlaps are compared, the others are
+  // taken as unchanged.
+  TiledImage Updated(const QImage &image, const QRect &dirty) const;
+  // Turns |image|, stored as |current|, back into this image. Only the tiles
+  // |current| does not share with this one are written, in place, unless
+  // the size or format differ.
+  void Restore(const TiledImage &current, QImage *image) const;
+
+  // Raw dump of the stored tiles, read back by Deserialize.
+  void Serialize(QDataStream *out) const;
+  static TiledImage Deserialize(QDataStream *in);
+
+private:
+  QSize size_;
+  QImage::Format format_;
+  QVector<QRgb> color_table_;
+  int columns_;
+  int rows_;
+  bool sparse_;
+  QHash<quint64, QImage> tiles_;
+  QImage empty_tile_;
+
+  static quint64 Key(int column, int row);
+
+  void Allocate(const QSize &size, QImage::Format format);
+  void DrawIndexed(const QImage &image, const QRect &target, QPainter::CompositionMode mode);
+  QImage &MutableTile(int column, int row);
+  QRect TileSpan(const QRect &rect) const;
+};
+
+#endif // TILED_IMAGE_H
@@ -25,7 +25,10 @@ void FloodFillTool::Use(QImage *image, const QColor &color, const ToolEvent &eve
   if( event.action()== ACTION_PRESS){
     if (event.lmb_down()) {
       event.undo_redo()->Do(*image);
-      ToolAlgorithm::FloodFill(image, event.img_pos(), color);
+      qint64 key = image->cacheKey();
+      ToolAlgorithm::FloodFill(image, event.img_pos(), color, event.mask());
+      // The fill may reach anywhere.
+      event.undo_redo()->Touch(key, *image, image->rect());
     } else if (event.rmb_down()) {
       pApp->main_window()->action_handler()->SetMainColor(image->pixel(event.img_pos()));
     }
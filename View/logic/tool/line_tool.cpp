@@ -41,8 +41,10 @@ void LineTool::Use(QImage *image, QImage *overlay, const QColor &color, QPoint *
       ToolAlgorithm::BresenhamLine(overlay, *anchor, event.img_pos(), color.rgba());
     }
   } else if (event.action() == ACTION_RELEASE) {
-    QPainter apply(image);
-    apply.drawImage(image->rect(), *overlay);
+    QRect drawn = QRect(*anchor, event.img_prev_pos()).normalized();
+    qint64 key = image->cacheKey();
+    ToolAlgorithm::ApplyOverlay(image, *overlay, drawn, event.mask());
+    event.undo_redo()->Touch(key, *image, drawn);
     overlay->fill(0x0);
     *started = false;
   }
@@ -19,10 +19,10 @@
 
 #include "pencil_tool.h"
 
+#include "logic/indexed_color.h"
 #include "logic/tool_algorithm.h"
 #include "logic/undo_redo.h"
 
-#include <QStatusBar>
 #include <QPainter>
 
 void PencilTool::Use(QImage *image, const QColor &color, const ToolEvent &event) {
@@ -31,14 +31,19 @@ void PencilTool::Use(QImage *image, const QColor &color, const ToolEvent &event)
       if(event.action() == ACTION_PRESS){
         event.undo_redo()->Do(*image);
       }
-      Algorithm(image, event.img_prev_pos(), event.img_pos(), color);
-      pApp->main_window()->statusBar()->showMessage("Teste",0);
+      qint64 key = image->cacheKey();
+      Algorithm(image, event.img_path(), color, event.mask());
+      QRect drawn;
+      for (const QPoint &p : event.img_path()) {
+        drawn |= QRect(p, QSize(1, 1));
+      }
+      event.undo_redo()->Touch(key, *image, drawn);
     } else if (event.rmb_down()) {
       pApp->main_window()->action_handler()->SetMainColor(image->pixel(event.img_pos()));
     }
   }
 }
 
-void PencilTool::Algorithm(QImage *image, const QPoint &p1, const QPoint p2, const QColor &color) {
-  ToolAlgorithm::BresenhamLine(image,p1,p2,color.rgba());
+void PencilTool::Algorithm(QImage *image, const QVector<QPoint> &path, const QColor &color, const BitMask *mask) {
+  ToolAlgorithm::BresenhamPolyline(image, path, IndexedColor::PixelValue(*image, color), mask);
 }
@@ -24,7 +24,7 @@
 
 namespace PencilTool {
   void Use(QImage *image, const QColor &color, const ToolEvent &event);
-  void Algorithm(QImage *image, const QPoint &p1, const QPoint p2, const QColor &color);
+  void Algorithm(QImage *image, const QVector<QPoint> &path, const QColor &color, const BitMask *mask = nullptr);
 }
 
 #endif // PENCIL_TOOL_H
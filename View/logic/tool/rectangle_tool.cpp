@@ -51,8 +51,10 @@ void RectangleTool::Use(QImage *image, QImage *overlay, const QColor &main_color
       }
     }
   } else if (event.action() == ACTION_RELEASE) {
-    QPainter apply(image);
-    apply.drawImage(image->rect(), *overlay);
+    QRect drawn = QRect(*anchor, event.img_prev_pos()).normalized();
+    qint64 key = image->cacheKey();
+    ToolAlgorithm::ApplyOverlay(image, *overlay, drawn, event.mask());
+    event.undo_redo()->Touch(key, *image, drawn);
     overlay->fill(0x0);
     *started = false;
   }
@@ -22,9 +22,7 @@
 #include "utils/debug.h"
 #include "logic/undo_redo.h"
 
-#include <QPainter>
-
-void SelectionTool::Use(QImage *image, QRect *selection, QImage *image_selected, const QColor &color, QPoint *anchor, bool *started, const ToolEvent &event) {
+void SelectionTool::Use(QImage *image, QRect *selection, FloatingSelection *floating, const QColor &color, QPoint *anchor, bool *started, const ToolEvent &event) {
   if (event.action() == ACTION_PRESS) {
     if (event.lmb_down()) {
       if (selection->isValid() && selection->contains(event.img_pos())) {
@@ -32,14 +30,16 @@ void SelectionTool::Use(QImage *image, QRect *selection, QImage *image_selected,
         *anchor = event.img_pos() - selection->center();
       } else {
         // Selection do not exist. Creating it.
-        ClearSelection(image, selection, image_selected);
+        qint64 key = image->cacheKey();
+        event.undo_redo()->Touch(key, *image, ClearSelection(image, selection, floating, event.mask()));
         *anchor = event.img_pos();
         *started = true;
         *selection = GetRect(*anchor, event.img_pos());
       }
     } else {
       // Pressing rmb clears the selection.
-      ClearSelection(image, selection, image_selected);
+      qint64 key = image->cacheKey();
+      event.undo_redo()->Touch(key, *image, ClearSelection(image, selection, floating, event.mask()));
     }
   } else if (event.action() == ACTION_MOVE) {
     if (*started) {
@@ -53,10 +53,10 @@ void SelectionTool::Use(QImage *image, QRect *selection, QImage *image_selected,
     }
   } else if (event.action() == ACTION_RELEASE) {
     if (*started == true) {
+      // The pixels stay in the image until the selection is put down.
       event.undo_redo()->Do(*image);
-      *image_selected = image->copy(*selection);
-      QPainter p(image);
-      p.fillRect(*selection, color);
+      *selection = selection->intersected(image->rect());
+      *floating = FloatingSelection(*image, *selection, color);
     }
     *started = false;
   }
@@ -70,11 +70,13 @@ QRect SelectionTool::GetRect(const QPoint &start, const QPoint &end) {
       qAbs(start.y() - end.y()) + 1);
 }
 
-void SelectionTool::ClearSelection(QImage *image, QRect *selection, QImage *image_selected) {
-  if (!image_selected->isNull()) {
-    QPainter p(image);
-    p.drawImage(*selection, *image_selected);
+QRect SelectionTool::ClearSelection(QImage *image, QRect *selection, FloatingSelection *floating, const BitMask *mask) {
+  QRect changed;
+  if (!floating->isNull() || floating->hole().isValid()) {
+    // The hole and where the pixels land.
+    changed = (floating->hole() | *selection).intersected(image->rect());
+    floating->Commit(image, *selection, mask);
   }
-  *image_selected = QImage();
   *selection = QRect();
+  return changed;
 }
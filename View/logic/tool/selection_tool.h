@@ -20,12 +20,15 @@
 #ifndef SELECTION_TOOL_H
 #define SELECTION_TOOL_H
 
+#include "logic/floating_selection.h"
 #include "logic/tool_algorithm.h"
 
 namespace SelectionTool {
-void Use(QImage *image, QRect *selection, QImage *image_selected, const QColor &color, QPoint *anchor, bool *started, const ToolEvent &event);
+void Use(QImage *image, QRect *selection, FloatingSelection *floating, const QColor &color, QPoint *anchor, bool *started, const ToolEvent &event);
 QRect GetRect(const QPoint &start, const QPoint &end);
-void ClearSelection(QImage *image, QRect *selection, QImage *image_selected);
+// Puts the floating pixels down at |selection| and forgets both. Returns the
+// area of |image| that changed.
+QRect ClearSelection(QImage *image, QRect *selection, FloatingSelection *floating, const BitMask *mask = nullptr);
 }
 
 #endif // SELECTION_TOOL_H
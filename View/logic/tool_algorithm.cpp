@@ -19,18 +19,29 @@
 
 #include "tool_algorithm.h"
 
+#include "logic/bit_mask.h"
+#include "logic/indexed_color.h"
 #include "utils/debug.h"
 #include "widgets/image_edit_widget.h"
 
 #include <QPainter>
 #include <cstdlib>
+#include <cstring>
 
-void ToolAlgorithm::FloodFill(QImage *image, const QPoint &seed, const QColor &color) {
-  QRgb new_color = color.rgba();
-  QRgb old_color = image->pixel(seed);
-  if (new_color == old_color) {
+namespace {
+bool Masked(const QImage *image, const BitMask *mask) {
+  return nullptr != mask && mask->size() == image->size();
+}
+}
+
+void ToolAlgorithm::FloodFill(QImage *image, const QPoint &seed, const QColor &color, const BitMask *mask) {
+  // Indexed images are filled by palette index.
+  uint new_color = IndexedColor::PixelValue(*image, color);
+  uint old_color = IndexedColor::RawPixel(*image, seed);
+  if (new_color == old_color || (Masked(image, mask) && mask->test(seed.x(), seed.y()))) {
     return;
   }
+  bool masked = Masked(image, mask);
   QList<QPoint> to_do_list = {seed};
 
   QVector<QPoint> expansion = {
@@ -48,7 +59,8 @@ void ToolAlgorithm::FloodFill(QImage *image, const QPoint &seed, const QColor &c
     for (QPoint e : expansion) {
       QPoint new_target = target + e;
       //DEBUG_MSG(new_target);
-      if (image->rect().contains(new_target) && image->pixel(new_target) == old_color) {
+      if (image->rect().contains(new_target) && IndexedColor::RawPixel(*image, new_target) == old_color &&
+          !(masked && mask->test(new_target.x(), new_target.y()))) {
         to_do_list.push_back(new_target);
         image->setPixel(new_target, new_color);
       }
@@ -56,7 +68,7 @@ void ToolAlgorithm::FloodFill(QImage *image, const QPoint &seed, const QColor &c
   }
 }
 
-void ToolAlgorithm::BresenhamLine(QImage *image, const QPoint &p1, const QPoint &p2, const QRgb &color) {
+void ToolAlgorithm::BresenhamLine(QImage *image, const QPoint &p1, const QPoint &p2, const QRgb &color, const BitMask *mask) {
   // Algorithm taken from http://www.roguebasin.com/index.php?title=Bresenham%27s_Line_Algorithm
 
   int x1 = p1.x();
@@ -72,7 +84,7 @@ void ToolAlgorithm::BresenhamLine(QImage *image, const QPoint &p1, const QPoint
   signed char const iy((delta_y > 0) - (delta_y < 0));
   delta_y = std::abs(delta_y) << 1;
 
-  SetPixel(image, x1, y1, color);
+  SetPixel(image, x1, y1, color, mask);
 
   if (delta_x >= delta_y) {
     int error(delta_y - (delta_x >> 1));
@@ -84,7 +96,7 @@ void ToolAlgorithm::BresenhamLine(QImage *image, const QPoint &p1, const QPoint
       error += delta_y;
       x1 += ix;
 
-      SetPixel(image, x1, y1, color);
+      SetPixel(image, x1, y1, color, mask);
     }
   } else {
     int error(delta_x - (delta_y >> 1));
@@ -96,12 +108,25 @@ void ToolAlgorithm::BresenhamLine(QImage *image, const QPoint &p1, const QPoint
       error += delta_x;
       y1 += iy;
 
-      SetPixel(image, x1, y1, color);
+      SetPixel(image, x1, y1, color, mask);
     }
   }
 }
 
-void ToolAlgorithm::BresenhamEllipse(QImage *image, const QRect &rect, bool fill, const QRgb &color) {
+void ToolAlgorithm::BresenhamPolyline(QImage *image, const QVector<QPoint> &path, const QRgb &color, const BitMask *mask) {
+  if (path.isEmpty()) {
+    return;
+  }
+  if (path.size() == 1) {
+    SetPixel(image, path.first(), color, mask);
+    return;
+  }
+  for (int i = 1; i < path.size(); i++) {
+    BresenhamLine(image, path[i - 1], path[i], color, mask);
+  }
+}
+
+void ToolAlgorithm::BresenhamEllipse(QImage *image, const QRect &rect, bool fill, const QRgb &color, const BitMask *mask) {
   // Algorithm from https://web.archive.org/web/20120225095359/http://homepage.smc.edu/kennedy_john/belipse.pdf
   QPoint c = rect.center();
   // Checks if the rect size is even on both directions
@@ -132,10 +157,10 @@ void ToolAlgorithm::BresenhamEllipse(QImage *image, const QRect &rect, bool fill
     last_h = QPoint(x, y);
     if (fill) {
       for (int i = 0; i < last_h.x(); i++) {
-        Plot4EllipsePoints(image, c, QPoint(i, last_h.y()), e, color);
+        Plot4EllipsePoints(image, c, QPoint(i, last_h.y()), e, color, mask);
       }
     } else {
-      Plot4EllipsePoints(image, c, last_h, e, color);
+      Plot4EllipsePoints(image, c, last_h, e, color, mask);
     }
     y++;
     stopping_y += two_a_square;
@@ -162,10 +187,10 @@ void ToolAlgorithm::BresenhamEllipse(QImage *image, const QRect &rect, bool fill
     last_v = QPoint(x, y);
     if (fill) {
       for (int i = 0; i < last_v.y(); i++) {
-        Plot4EllipsePoints(image, c, QPoint(last_v.x(), i), e, color);
+        Plot4EllipsePoints(image, c, QPoint(last_v.x(), i), e, color, mask);
       }
     } else {
-      Plot4EllipsePoints(image, c, last_v, e, color);
+      Plot4EllipsePoints(image, c, last_v, e, color, mask);
     }
     x++;
     stopping_x += two_b_square;
@@ -181,11 +206,11 @@ void ToolAlgorithm::BresenhamEllipse(QImage *image, const QRect &rect, bool fill
 
   // The two ellipse parts are separated and must be connected
   if (abs(last_h.x() - last_v.x()) > 1 || abs(last_h.y() - last_v.y()) > 1) {
-    Bresenham4LinesEllipse(image, last_h, last_v, c, e, color);
+    Bresenham4LinesEllipse(image, last_h, last_v, c, e, color, mask);
   }
 }
 
-void ToolAlgorithm::Bresenham4LinesEllipse(QImage *image, const QPoint &p1, const QPoint &p2, const QPoint &c, const QPoint &e, const QRgb &color) {
+void ToolAlgorithm::Bresenham4LinesEllipse(QImage *image, const QPoint &p1, const QPoint &p2, const QPoint &c, const QPoint &e, const QRgb &color, const BitMask *mask) {
   // Algorithm taken from http://www.roguebasin.com/index.php?title=Bresenham%27s_Line_Algorithm
 
   int x1 = p1.x();
@@ -201,7 +226,7 @@ void ToolAlgorithm::Bresenham4LinesEllipse(QImage *image, const QPoint &p1, cons
   signed char const iy((delta_y > 0) - (delta_y < 0));
   delta_y = std::abs(delta_y) << 1;
 
-  Plot4EllipsePoints(image, c, QPoint(x1, y1), e, color);
+  Plot4EllipsePoints(image, c, QPoint(x1, y1), e, color, mask);
 
   if (delta_x >= delta_y) {
     int error(delta_y - (delta_x >> 1));
@@ -213,7 +238,7 @@ void ToolAlgorithm::Bresenham4LinesEllipse(QImage *image, const QPoint &p1, cons
       error += delta_y;
       x1 += ix;
 
-      Plot4EllipsePoints(image, c, QPoint(x1, y1), e, color);
+      Plot4EllipsePoints(image, c, QPoint(x1, y1), e, color, mask);
     }
   } else {
     int error(delta_x - (delta_y >> 1));
@@ -225,28 +250,110 @@ void ToolAlgorithm::Bresenham4LinesEllipse(QImage *image, const QPoint &p1, cons
       error += delta_x;
       y1 += iy;
 
-      Plot4EllipsePoints(image, c, QPoint(x1, y1), e, color);
+      Plot4EllipsePoints(image, c, QPoint(x1, y1), e, color, mask);
     }
   }
 }
 
-void ToolAlgorithm::Plot4EllipsePoints(QImage *image, const QPoint &c, const QPoint &p, const QPoint &e, const QRgb &color) {
+void ToolAlgorithm::Plot4EllipsePoints(QImage *image, const QPoint &c, const QPoint &p, const QPoint &e, const QRgb &color, const BitMask *mask) {
   QPoint p1 = c + p;
   QPoint p2 = c - p + e;
-  SetPixel(image, p1, color);
-  SetPixel(image, p2, color);
-  SetPixel(image, p1.x(), p2.y(), color);
-  SetPixel(image, p2.x(), p1.y(), color);
+  SetPixel(image, p1, color, mask);
+  SetPixel(image, p2, color, mask);
+  SetPixel(image, p1.x(), p2.y(), color, mask);
+  SetPixel(image, p2.x(), p1.y(), color, mask);
 }
 
-void ToolAlgorithm::SetPixel(QImage *image, const QPoint &p, const QRgb &color) {
-  if (image->rect().contains(p)) {
+void ToolAlgorithm::SetPixel(QImage *image, const QPoint &p, const QRgb &color, const BitMask *mask) {
+  if (image->rect().contains(p) && !(Masked(image, mask) && mask->test(p.x(), p.y()))) {
     image->setPixel(p, color);
   }
 }
 
-void ToolAlgorithm::SetPixel(QImage *image, const int x, const int y, const QRgb &color) {
-  if (image->rect().contains(x, y)) {
+void ToolAlgorithm::SetPixel(QImage *image, const int x, const int y, const QRgb &color, const BitMask *mask) {
+  if (image->rect().contains(x, y) && !(Masked(image, mask) && mask->test(x, y))) {
     image->setPixel(x, y, color);
   }
 }
+
+void ToolAlgorithm::ApplyOverlay(QImage *image, const QImage &overlay, const QRect &rect, const BitMask *mask) {
+  QRect r = rect.intersected(image->rect()).intersected(overlay.rect());
+  if (r.isEmpty()) {
+    return;
+  }
+  if (Masked(image, mask)) {
+    // Paint unmasked, then put the protected pixels back.
+    QImage before = image->copy(r);
+    ApplyOverlay(image, overlay, r);
+    mask->RestoreMasked(image, before, r.topLeft());
+    return;
+  }
+  if (image->format() != QImage::Format_Indexed8) {
+    QPainter apply(image);
+    apply.drawImage(r, overlay, r);
+    return;
+  }
+  IndexedColor::IndexMapper mapper(image->colorTable());
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    uchar *out = image->scanLine(y);
+    for (int x = r.left(); x <= r.right(); x++) {
+      QRgb c = overlay.pixel(x, y);
+      if (qAlpha(c) != 0) {
+        out[x] = mapper.Map(c);
+      }
+    }
+  }
+}
+
+void ToolAlgorithm::FillRect(QImage *image, const QRect &rect, const QColor &color, const BitMask *mask) {
+  if (Masked(image, mask)) {
+    QRect area = rect.intersected(image->rect());
+    QImage before = image->copy(area);
+    FillRect(image, rect, color);
+    mask->RestoreMasked(image, before, area.topLeft());
+    return;
+  }
+  if (image->format() != QImage::Format_Indexed8) {
+    QPainter p(image);
+    p.fillRect(rect, color);
+    return;
+  }
+  QRect r = rect.intersected(image->rect());
+  uchar index = IndexedColor::PixelValue(*image, color);
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    memset(image->scanLine(y) + r.left(), index, r.width());
+  }
+}
+
+void ToolAlgorithm::DrawImage(QImage *image, const QRect &target, const QImage &source, const BitMask *mask) {
+  if (Masked(image, mask)) {
+    QRect area = target.intersected(image->rect());
+    QImage before = image->copy(area);
+    DrawImage(image, target, source);
+    mask->RestoreMasked(image, before, area.topLeft());
+    return;
+  }
+  if (image->format() != QImage::Format_Indexed8) {
+    QPainter p(image);
+    p.drawImage(target, source);
+    return;
+  }
+  QImage src = source.size() == target.size() ? source : source.scaled(target.size());
+  QRect r = target.intersected(image->rect());
+  bool same_palette = src.format() == QImage::Format_Indexed8 && src.colorTable() == image->colorTable();
+  IndexedColor::IndexMapper mapper(image->colorTable());
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    uchar *out = image->scanLine(y);
+    int src_y = y - target.top();
+    if (same_palette) {
+      memcpy(out + r.left(), src.constScanLine(src_y) + r.left() - target.left(), r.width());
+      continue;
+    }
+    for (int x = r.left(); x <= r.right(); x++) {
+      QRgb c = src.pixel(x - target.left(), src_y);
+      if (qAlpha(c) != 0) {
+        out[x] = mapper.Map(c);
+      }
+    }
+  }
+}
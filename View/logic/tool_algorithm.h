@@ -23,11 +23,13 @@
 #include <QColor>
 #include <QImage>
 #include <QPoint>
+#include <QVector>
 
 #include "application/pixel_booster.h"
 #include "logic/action_handler.h"
 #include "screens/main_window.h"
 
+class BitMask;
 class UndoRedo;
 
 enum ACTION_TOOL : int {
@@ -44,19 +46,28 @@ public:
             bool rmb_down,
             const QPoint &img_pos,
             const QPoint &img_prev_pos,
-            UndoRedo *undo_redo) : action_(action),
+            const QVector<QPoint> &img_path,
+            UndoRedo *undo_redo,
+            const BitMask *mask = nullptr) : action_(action),
                                    lmb_down_(lmb_down),
                                    rmb_down_(rmb_down),
                                    img_pos_(img_pos),
                                    img_prev_pos_(img_prev_pos),
-                                   undo_redo_(undo_redo) {
+                                   img_path_(img_path),
+                                   undo_redo_(undo_redo),
+                                   mask_(mask) {
   }
   ACTION_TOOL action() const { return action_; }
   bool lmb_down() const { return lmb_down_; }
   bool rmb_down() const { return rmb_down_; }
   QPoint img_pos() const { return img_pos_; }
   QPoint img_prev_pos() const { return img_prev_pos_; }
+  // Every sample from img_prev_pos to img_pos, in order. Mouse moves are
+  // coalesced once per frame, so one event may carry many input samples.
+  const QVector<QPoint> &img_path() const { return img_path_; }
   UndoRedo *undo_redo() const { return undo_redo_; }
+  // Protection mask of the edited image, nullptr when nothing is masked.
+  const BitMask *mask() const { return mask_; }
 
 private:
   ACTION_TOOL action_;
@@ -64,20 +75,32 @@ private:
   bool rmb_down_;
   QPoint img_pos_;
   QPoint img_prev_pos_;
+  QVector<QPoint> img_path_;
   UndoRedo *undo_redo_;
+  const BitMask *mask_;
 };
 
+// Every kernel takes an optional protection mask: pixels whose bit is set are
+// left untouched, and flood fills treat them as walls.
 namespace ToolAlgorithm {
-void FloodFill(QImage *image, const QPoint &seed, const QColor &color);
+void FloodFill(QImage *image, const QPoint &seed, const QColor &color, const BitMask *mask = nullptr);
 
-void BresenhamLine(QImage *image, const QPoint &p1, const QPoint &p2, const QRgb &color);
+void BresenhamLine(QImage *image, const QPoint &p1, const QPoint &p2, const QRgb &color, const BitMask *mask = nullptr);
+void BresenhamPolyline(QImage *image, const QVector<QPoint> &path, const QRgb &color, const BitMask *mask = nullptr);
 
-void BresenhamEllipse(QImage *image, const QRect &rect, bool fill, const QRgb &color);
-void Bresenham4LinesEllipse(QImage *image, const QPoint &p1, const QPoint &p2, const QPoint &c, const QPoint &e, const QRgb &color);
-void Plot4EllipsePoints(QImage *image, const QPoint &c, const QPoint &p, const QPoint &e, const QRgb &color);
+void BresenhamEllipse(QImage *image, const QRect &rect, bool fill, const QRgb &color, const BitMask *mask = nullptr);
+void Bresenham4LinesEllipse(QImage *image, const QPoint &p1, const QPoint &p2, const QPoint &c, const QPoint &e, const QRgb &color, const BitMask *mask = nullptr);
+void Plot4EllipsePoints(QImage *image, const QPoint &c, const QPoint &p, const QPoint &e, const QRgb &color, const BitMask *mask = nullptr);
 
-void SetPixel(QImage *image, const QPoint &p, const QRgb &color);
-void SetPixel(QImage *image, const int x, const int y, const QRgb &color);
+void SetPixel(QImage *image, const QPoint &p, const QRgb &color, const BitMask *mask = nullptr);
+void SetPixel(QImage *image, const int x, const int y, const QRgb &color, const BitMask *mask = nullptr);
+
+// QPainter counterparts that also work on 8 bit indexed images, where colors
+// are mapped to the nearest palette entry. Only the |rect| part of |overlay|,
+// all a tool drew on it, is applied.
+void ApplyOverlay(QImage *image, const QImage &overlay, const QRect &rect, const BitMask *mask = nullptr);
+void FillRect(QImage *image, const QRect &rect, const QColor &color, const BitMask *mask = nullptr);
+void DrawImage(QImage *image, const QRect &target, const QImage &source, const BitMask *mask = nullptr);
 }
 
 #endif // TOOLALGORITHM_H
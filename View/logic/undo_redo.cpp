@@ -21,47 +21,119 @@
 
 #include <QDateTime>
 
+#include "pb_image.h"
 #include "utils/debug.h"
 
 const int kUndoRedoSize = 12;
+// Shifts closer than this are taken as one held key. It is above the usual
+// delay before a key starts repeating.
+const qint64 kShiftRepeatMsecs = 600;
 
-UndoRedo::UndoRedo() {}
+UndoRedo::UndoRedo() : synced_key_(0) {}
 
 void UndoRedo::Do(const QImage &img) {
-  undo.Push(img, QDateTime::currentMSecsSinceEpoch());
+  // Consecutive states mostly differ in a few tiles, share the rest.
+  TiledImage state = Snapshot(img, undo.IsEmpty() ? TiledImage() : undo.data[undo.first].image);
+  undo.Push(state, QDateTime::currentMSecsSinceEpoch());
   redo.Clear();
+  Sync(state, img);
 }
 
-QImage UndoRedo::Undo(const QImage &current) {
-  if (!undo.IsEmpty()) {
-    redo.Push(current, QDateTime::currentMSecsSinceEpoch());
+void UndoRedo::Touch(qint64 key, const QImage &img, const QRect &rect) {
+  if (synced_.isNull() || rect.isEmpty()) {
+    return;
   }
-  QImage u = undo.Pop();
-  return u;
+  if (key != synced_key_) {
+    // Edited without a touch before, the tracking is lost until the next
+    // Do, Undo or Redo.
+    synced_ = TiledImage();
+    dirty_ = QRect();
+    return;
+  }
+  dirty_ |= rect;
+  synced_key_ = img.cacheKey();
+}
+
+void UndoRedo::DoFlip(Qt::Orientations flip) {
+  undo.PushFlip(flip, QDateTime::currentMSecsSinceEpoch());
+  redo.Clear();
+}
+
+void UndoRedo::DoShift(const QPoint &shift) {
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  redo.Clear();
+  if (!undo.IsEmpty() && !undo.CheckShift().isNull() && now - undo.Check() < kShiftRepeatMsecs) {
+    undo.data[undo.first].shift += shift;
+    undo.data[undo.first].timestamp = now;
+    return;
+  }
+  undo.PushShift(shift, now);
+}
+
+bool UndoRedo::Undo(QImage *image) {
+  return Step(&undo, &redo, image, true);
 }
 
 qint64 UndoRedo::UndoTimestamp() const {
   return undo.Check();
 }
 
-QImage UndoRedo::Redo(const QImage &current) {
-  if (!redo.IsEmpty()) {
-    undo.Push(current, QDateTime::currentMSecsSinceEpoch());
-  }
-  QImage r = redo.Pop();
-  return r;
+bool UndoRedo::Redo(QImage *image) {
+  return Step(&redo, &undo, image, false);
 }
 
 qint64 UndoRedo::RedoTimestamp() const {
   return redo.Check();
 }
 
+bool UndoRedo::Step(UndoRedoStack *from, UndoRedoStack *to, QImage *image, bool back) {
+  if (from->IsEmpty()) {
+    return false;
+  }
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  Qt::Orientations flip = from->CheckFlip();
+  QPoint shift = from->CheckShift();
+  if (flip) {
+    // A flip is its own inverse, the other stack gets the same entry.
+    from->Pop();
+    to->PushFlip(flip, now);
+    FlipInPlace(image, flip & Qt::Horizontal, flip & Qt::Vertical);
+  } else if (!shift.isNull()) {
+    from->Pop();
+    to->PushShift(shift, now);
+    if (back) {
+      shift = -shift;
+    }
+    ShiftInPlace(image, shift.x(), shift.y());
+  } else {
+    TiledImage state = from->Pop();
+    TiledImage current = Snapshot(*image, state);
+    to->Push(current, now);
+    state.Restore(current, image);
+    Sync(state, *image);
+  }
+  return true;
+}
+
+TiledImage UndoRedo::Snapshot(const QImage &img, const TiledImage &base) const {
+  if (!synced_.isNull() && img.cacheKey() == synced_key_) {
+    return synced_.Updated(img, dirty_);
+  }
+  return base.Updated(img);
+}
+
+void UndoRedo::Sync(const TiledImage &state, const QImage &img) {
+  synced_ = state;
+  dirty_ = QRect();
+  synced_key_ = img.cacheKey();
+}
+
 UndoRedo::UndoRedoStack::UndoRedoStack() : first(-1),
                                            last(0) {
   data.resize(kUndoRedoSize);
 }
 
-bool UndoRedo::UndoRedoStack::IsEmpty() {
+bool UndoRedo::UndoRedoStack::IsEmpty() const {
   return (first == -1);
 }
 
@@ -69,7 +141,31 @@ void UndoRedo::UndoRedoStack::Clear() {
   first = -1;
 }
 
-void UndoRedo::UndoRedoStack::Push(const QImage &img, qint64 timestamp) {
+void UndoRedo::UndoRedoStack::Push(const TiledImage &state, qint64 timestamp) {
+  int i = Advance();
+  data[i].image = state;
+  data[i].timestamp = timestamp;
+  data[i].flip = 0;
+  data[i].shift = QPoint();
+}
+
+void UndoRedo::UndoRedoStack::PushFlip(Qt::Orientations flip, qint64 timestamp) {
+  int i = Advance();
+  data[i].image = TiledImage();
+  data[i].timestamp = timestamp;
+  data[i].flip = flip;
+  data[i].shift = QPoint();
+}
+
+void UndoRedo::UndoRedoStack::PushShift(const QPoint &shift, qint64 timestamp) {
+  int i = Advance();
+  data[i].image = TiledImage();
+  data[i].timestamp = timestamp;
+  data[i].flip = 0;
+  data[i].shift = shift;
+}
+
+int UndoRedo::UndoRedoStack::Advance() {
   if (first == -1) {
     // Only one element at the stack.
     first = last;
@@ -82,18 +178,25 @@ void UndoRedo::UndoRedoStack::Push(const QImage &img, qint64 timestamp) {
       last %= data.length();
     }
   }
-  data[first].image = img;
-  data[first].timestamp = timestamp;
+  return first;
 }
 
 qint64 UndoRedo::UndoRedoStack::Check() const {
-  return data[first].timestamp;
+  return IsEmpty() ? 0 : data[first].timestamp;
+}
+
+Qt::Orientations UndoRedo::UndoRedoStack::CheckFlip() const {
+  return data[first].flip;
+}
+
+QPoint UndoRedo::UndoRedoStack::CheckShift() const {
+  return data[first].shift;
 }
 
-QImage UndoRedo::UndoRedoStack::Pop() {
+TiledImage UndoRedo::UndoRedoStack::Pop() {
   if (first == -1) {
     // Empty stack;
-    return QImage(0, 0, QImage::Format_Invalid);
+    return TiledImage();
   } else if (first == last) {
     first = -1;
     return data[last].image;
@@ -22,15 +22,39 @@
 
 #include <QImage>
 
+#include "tiled_image.h"
+
+/*!
+ * \brief Bounded undo and redo history.
+ *
+ * States are kept as TiledImage snapshots. Each one shares every unchanged
+ * tile with the state pushed before it, so an entry only costs the tiles an
+ * edit touched. Undo and redo diff the image against the state they step
+ * to, so the entry for the other stack shares its unchanged tiles and only
+ * the changed tiles are written back. Flips and shifts keep no snapshot at
+ * all, they are undone by flipping or shifting the image back.
+ *
+ * Tools mark the area they draw on with Touch, so a snapshot only compares
+ * the tiles edited since the last one. The image cache key tells when an
+ * edit nobody marked came in between, that snapshot compares every tile.
+ */
 class UndoRedo {
 public:
   UndoRedo();
   //  ~UndoRedo();
 
   void Do(const QImage &img);
-  QImage Undo(const QImage &current);
+  // |rect| of |img| was just edited, |key| is the img cache key from before.
+  void Touch(qint64 key, const QImage &img, const QRect &rect);
+  void DoFlip(Qt::Orientations flip);
+  // Shifts repeated in quick succession (a held key) add up in one entry.
+  void DoShift(const QPoint &shift);
+  // Steps |image| back (or forward) one state, in place for flips. Returns
+  // false when there is nothing to undo.
+  bool Undo(QImage *image);
+  // When the next step to undo was done, 0 if there is none.
   qint64 UndoTimestamp() const;
-  QImage Redo(const QImage &current);
+  bool Redo(QImage *image);
   qint64 RedoTimestamp() const;
 
 private:
@@ -38,8 +62,11 @@ private:
   private:
     class UndoRedoState {
     public:
-      QImage image;
+      TiledImage image;
       qint64 timestamp;
+      // Set for flip and shift entries, which hold no image.
+      Qt::Orientations flip;
+      QPoint shift;
     };
 
   public:
@@ -48,15 +75,36 @@ private:
     int first;
     int last;
 
-    bool IsEmpty();
+    bool IsEmpty() const;
     void Clear();
-    void Push(const QImage &img, qint64 timestamp);
+    void Push(const TiledImage &state, qint64 timestamp);
+    void PushFlip(Qt::Orientations flip, qint64 timestamp);
+    void PushShift(const QPoint &shift, qint64 timestamp);
     qint64 Check() const;
-    QImage Pop();
+    Qt::Orientations CheckFlip() const;
+    QPoint CheckShift() const;
+    TiledImage Pop();
+
+  private:
+    int Advance();
   };
 
+  // |back| reverts the entry taken from |from|, otherwise it is applied.
+  bool Step(UndoRedoStack *from, UndoRedoStack *to, QImage *image, bool back);
+  // |img| sharing its unchanged tiles: with synced_, comparing the touched
+  // ones, when marked edits are all it went through since. Otherwise with
+  // |base|, comparing every tile.
+  TiledImage Snapshot(const QImage &img, const TiledImage &base) const;
+  void Sync(const TiledImage &state, const QImage &img);
+
   UndoRedoStack undo;
   UndoRedoStack redo;
+
+  // The image as of the last Do, Undo or Redo, the area touched since and
+  // the image cache key after the last touch.
+  TiledImage synced_;
+  QRect dirty_;
+  qint64 synced_key_;
 };
 
 #endif // UNDO_REDO_H
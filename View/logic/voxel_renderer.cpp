@@ -0,0 +1,166 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "voxel_renderer.h"
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "logic/voxel_volume.h"
+
+// A voxel is drawn 4 pixels wide: a 2 pixel high top face over 2 pixel high
+// left and right faces.
+const int kVoxelHalfWidth = 2;
+const int kVoxelFaceHeight = 2;
+
+// Bands smaller than this are not worth a thread.
+const int kMinBandHeight = 16;
+
+QRgb Shade(QRgb color, int percent) {
+  return qRgb(qRed(color) * percent / 100, qGreen(color) * percent / 100, qBlue(color) * percent / 100);
+}
+
+void FillSpan(uchar *bits, int bytes_per_line, const QRect &rect, const QRect &clip, QRgb color) {
+  QRect r = rect.intersected(clip);
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    QRgb *line = reinterpret_cast<QRgb *>(bits + y * bytes_per_line);
+    for (int x = r.left(); x <= r.right(); x++) {
+      line[x] = color;
+    }
+  }
+}
+
+VoxelRenderer::VoxelRenderer() : width_(0),
+                                 height_(0),
+                                 depth_(0) {
+}
+
+void VoxelRenderer::Build(const VoxelVolume &volume) {
+  width_ = volume.width();
+  height_ = volume.height();
+  depth_ = volume.depth();
+  columns_.clear();
+  columns_.resize(width_ * height_);
+  if (volume.isNull()) {
+    image_ = QImage();
+    return;
+  }
+
+  image_ = QImage((width_ + height_) * kVoxelHalfWidth, width_ + height_ + depth_ * kVoxelFaceHeight + kVoxelFaceHeight, QImage::Format_ARGB32_Premultiplied);
+  Update(volume, QRect(0, 0, width_, height_));
+}
+
+void VoxelRenderer::Update(const VoxelVolume &volume, const QRect &columns) {
+  QRect r = columns.intersected(QRect(0, 0, width_, height_));
+  if (r.isEmpty()) {
+    return;
+  }
+  for (int y = r.top(); y <= r.bottom(); y++) {
+    for (int x = r.left(); x <= r.right(); x++) {
+      EncodeColumn(volume, x, y);
+    }
+  }
+  Render(ScreenRect(r).intersected(image_.rect()));
+}
+
+const QImage &VoxelRenderer::image() const {
+  return image_;
+}
+
+void VoxelRenderer::EncodeColumn(const VoxelVolume &volume, int x, int y) {
+  QVector<Run> &runs = columns_[y * width_ + x];
+  runs.clear();
+  for (int z = 0; z < depth_; z++) {
+    QRgb v = volume.voxel(x, y, z);
+    if (qAlpha(v) == 0) {
+      continue;
+    }
+    if (!runs.isEmpty() && runs.last().color == v && runs.last().z + runs.last().length == z) {
+      runs.last().length++;
+    } else {
+      Run run = {quint16(z), 1, v};
+      runs.push_back(run);
+    }
+  }
+}
+
+QRect VoxelRenderer::ScreenRect(const QRect &columns) const {
+  // Columns project to x = (x - y) and y = (x + y) - z steps.
+  int left = (columns.left() - columns.bottom() + height_ - 1) * kVoxelHalfWidth;
+  int right = (columns.right() - columns.top() + height_ + 1) * kVoxelHalfWidth;
+  int top = columns.left() + columns.top();
+  int bottom = columns.right() + columns.bottom() + (depth_ + 2) * kVoxelFaceHeight;
+  return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void VoxelRenderer::Render(const QRect &area) {
+  if (area.isEmpty()) {
+    return;
+  }
+  // Detach once here, the bands write to disjoint rows from other threads.
+  uchar *bits = image_.bits();
+  int bytes_per_line = image_.bytesPerLine();
+
+  int bands = qMax(1, qMin(QThread::idealThreadCount(), area.height() / kMinBandHeight));
+  QVector<QRect> band_rects;
+  for (int i = 0; i < bands; i++) {
+    int top = area.top() + area.height() * i / bands;
+    int bottom = area.top() + area.height() * (i + 1) / bands;
+    band_rects.push_back(QRect(area.left(), top, area.width(), bottom - top));
+  }
+  QtConcurrent::blockingMap(band_rects, [this, bits, bytes_per_line](QRect &band) { RenderBand(band, bits, bytes_per_line); });
+}
+
+void VoxelRenderer::RenderBand(const QRect &band, uchar *bits, int bytes_per_line) {
+  FillSpan(bits, bytes_per_line, band, band, 0x0);
+
+  // Back to front: columns further from the viewer have a smaller x + y.
+  // A diagonal covers the rows from its highest top face to its lowest side.
+  for (int diagonal = 0; diagonal < width_ + height_ - 1; diagonal++) {
+    if (diagonal + kVoxelFaceHeight > band.bottom()) {
+      break;
+    }
+    if (diagonal + (depth_ + 2) * kVoxelFaceHeight <= band.top()) {
+      continue;
+    }
+    for (int x = qMax(0, diagonal - height_ + 1); x <= qMin(width_ - 1, diagonal); x++) {
+      int y = diagonal - x;
+      int screen_x = (x - y + height_ - 1) * kVoxelHalfWidth;
+      if (screen_x + 2 * kVoxelHalfWidth <= band.left() || screen_x > band.right()) {
+        continue;
+      }
+      // Screen y of the top face of the voxel at height z.
+      int base = diagonal + depth_ * kVoxelFaceHeight;
+      for (const Run &run : columns_[y * width_ + x]) {
+        int top_z = run.z + run.length - 1;
+        int face_top = base - top_z * kVoxelFaceHeight;
+        int side_height = run.length * kVoxelFaceHeight;
+        QRgb color = qRgb(qRed(run.color), qGreen(run.color), qBlue(run.color));
+        if (qAlpha(run.color) != 255) {
+          // Premultiplied, bring the color back to full strength.
+          int a = qAlpha(run.color);
+          color = qRgb(qRed(run.color) * 255 / a, qGreen(run.color) * 255 / a, qBlue(run.color) * 255 / a);
+        }
+        FillSpan(bits, bytes_per_line, QRect(screen_x, face_top + kVoxelFaceHeight, kVoxelHalfWidth, side_height), band, Shade(color, 60));
+        FillSpan(bits, bytes_per_line, QRect(screen_x + kVoxelHalfWidth, face_top + kVoxelFaceHeight, kVoxelHalfWidth, side_height), band, Shade(color, 80));
+        FillSpan(bits, bytes_per_line, QRect(screen_x, face_top, 2 * kVoxelHalfWidth, kVoxelFaceHeight), band, color);
+      }
+    }
+  }
+}
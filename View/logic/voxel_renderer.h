@@ -0,0 +1,68 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef VOXEL_RENDERER_H
+#define VOXEL_RENDERER_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+class VoxelVolume;
+
+/*!
+ * \brief Isometric CPU preview of a VoxelVolume.
+ *
+ * Each x, y column of the model is kept as runs of equal voxels along z, and
+ * a run is drawn as one strip, so the cost follows the number of runs, not
+ * voxels. The image is split in horizontal bands rendered on all cores. When
+ * a slice changes only its columns are re-encoded and only the part of the
+ * image they cover is drawn again.
+ */
+class VoxelRenderer {
+public:
+  VoxelRenderer();
+
+  // Encodes every column and renders the whole image.
+  void Build(const VoxelVolume &volume);
+  // Re-encodes the |columns| (x, y) rect and redraws what it covers.
+  void Update(const VoxelVolume &volume, const QRect &columns);
+  const QImage &image() const;
+
+private:
+  struct Run {
+    quint16 z;
+    quint16 length;
+    QRgb color;
+  };
+
+  int width_;
+  int height_;
+  int depth_;
+  QVector<QVector<Run>> columns_;
+  QImage image_;
+
+  void EncodeColumn(const VoxelVolume &volume, int x, int y);
+  // Image area the |columns| rect may draw to, whatever its contents.
+  QRect ScreenRect(const QRect &columns) const;
+  void Render(const QRect &area);
+  void RenderBand(const QRect &band, uchar *bits, int bytes_per_line);
+};
+
+#endif // VOXEL_RENDERER_H
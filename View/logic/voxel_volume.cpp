@@ -0,0 +1,124 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "voxel_volume.h"
+
+#include <cstring>
+
+VoxelVolume::Brick::Brick() : count(0) {
+}
+
+VoxelVolume::VoxelVolume() : width_(0),
+                             height_(0),
+                             depth_(0) {
+}
+
+VoxelVolume::VoxelVolume(int width, int height, int depth) : width_(width),
+                                                             height_(height),
+                                                             depth_(depth) {
+}
+
+bool VoxelVolume::isNull() const {
+  return width_ <= 0 || height_ <= 0 || depth_ <= 0;
+}
+
+int VoxelVolume::width() const {
+  return width_;
+}
+
+int VoxelVolume::height() const {
+  return height_;
+}
+
+int VoxelVolume::depth() const {
+  return depth_;
+}
+
+int VoxelVolume::brick_count() const {
+  return bricks_.size();
+}
+
+QRgb VoxelVolume::voxel(int x, int y, int z) const {
+  auto it = bricks_.constFind(Key(x / kBrickSize, y / kBrickSize, z / kBrickSize));
+  return it == bricks_.constEnd() ? 0 : it->voxels[Index(x, y, z)];
+}
+
+void VoxelVolume::SetVoxel(int x, int y, int z, QRgb color) {
+  quint64 key = Key(x / kBrickSize, y / kBrickSize, z / kBrickSize);
+  auto it = bricks_.find(key);
+  if (it == bricks_.end()) {
+    if (qAlpha(color) == 0) {
+      return;
+    }
+    Brick brick;
+    brick.voxels.fill(0, kBrickSize * kBrickSize * kBrickSize);
+    it = bricks_.insert(key, brick);
+  }
+
+  QRgb &v = it->voxels[Index(x, y, z)];
+  it->count += (qAlpha(color) != 0) - (qAlpha(v) != 0);
+  v = color;
+  if (it->count == 0) {
+    bricks_.erase(it);
+  }
+}
+
+QImage VoxelVolume::Slice(int z) const {
+  QImage slice(width_, height_, QImage::Format_ARGB32_Premultiplied);
+  slice.fill(0x0);
+  int brick_z = z / kBrickSize;
+  for (auto it = bricks_.constBegin(); it != bricks_.constEnd(); ++it) {
+    if (int(it.key() & 0xffff) != brick_z) {
+      continue;
+    }
+    int x0 = int(it.key() >> 32) * kBrickSize;
+    int y0 = int((it.key() >> 16) & 0xffff) * kBrickSize;
+    int w = qMin(kBrickSize, width_ - x0);
+    for (int y = y0; y < qMin(y0 + kBrickSize, height_); y++) {
+      const QRgb *row = it->voxels.constData() + Index(0, y, z);
+      std::memcpy(reinterpret_cast<QRgb *>(slice.scanLine(y)) + x0, row, w * sizeof(QRgb));
+    }
+  }
+  return slice;
+}
+
+QRect VoxelVolume::SetSlice(int z, const QImage &image) {
+  QImage source = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+  QRect changed;
+  int h = qMin(height_, source.height());
+  int w = qMin(width_, source.width());
+  for (int y = 0; y < h; y++) {
+    const QRgb *row = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+    for (int x = 0; x < w; x++) {
+      if (voxel(x, y, z) != row[x]) {
+        SetVoxel(x, y, z, row[x]);
+        changed |= QRect(x, y, 1, 1);
+      }
+    }
+  }
+  return changed;
+}
+
+quint64 VoxelVolume::Key(int brick_x, int brick_y, int brick_z) {
+  return (quint64(brick_x) << 32) | (quint64(brick_y) << 16) | quint64(brick_z);
+}
+
+int VoxelVolume::Index(int x, int y, int z) {
+  return ((z % kBrickSize) * kBrickSize + (y % kBrickSize)) * kBrickSize + (x % kBrickSize);
+}
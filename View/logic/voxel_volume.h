@@ -0,0 +1,73 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef VOXEL_VOLUME_H
+#define VOXEL_VOLUME_H
+
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+/*!
+ * \brief Voxel model stored in cubic bricks.
+ *
+ * Only bricks holding at least one voxel are allocated, an empty 128^3 model
+ * takes no voxel memory at all. A voxel is a premultiplied color, fully
+ * transparent voxels are empty. The model is edited one z slice at a time.
+ */
+class VoxelVolume {
+public:
+  static const int kBrickSize = 16;
+
+  VoxelVolume();
+  VoxelVolume(int width, int height, int depth);
+
+  bool isNull() const;
+  int width() const;
+  int height() const;
+  int depth() const;
+  int brick_count() const;
+
+  QRgb voxel(int x, int y, int z) const;
+  void SetVoxel(int x, int y, int z, QRgb color);
+
+  // The voxels at height |z| as a width x height image.
+  QImage Slice(int z) const;
+  // Replaces the voxels at height |z|, returns the columns that changed.
+  QRect SetSlice(int z, const QImage &image);
+
+private:
+  struct Brick {
+    Brick();
+
+    QVector<QRgb> voxels;
+    int count;
+  };
+
+  int width_;
+  int height_;
+  int depth_;
+  QHash<quint64, Brick> bricks_;
+
+  static quint64 Key(int brick_x, int brick_y, int brick_z);
+  static int Index(int x, int y, int z);
+};
+
+#endif // VOXEL_VOLUME_H
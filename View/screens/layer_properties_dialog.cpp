@@ -0,0 +1,62 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "layer_properties_dialog.h"
+#include "ui_layer_properties_dialog.h"
+
+const QPair<QPainter::CompositionMode, QString> kBlendModeOptions[] = {
+    {QPainter::CompositionMode_SourceOver, "Normal"},
+    {QPainter::CompositionMode_Multiply, "Multiply"},
+    {QPainter::CompositionMode_Screen, "Screen"},
+    {QPainter::CompositionMode_Overlay, "Overlay"},
+    {QPainter::CompositionMode_Darken, "Darken"},
+    {QPainter::CompositionMode_Lighten, "Lighten"},
+    {QPainter::CompositionMode_Plus, "Add"},
+    {QPainter::CompositionMode_Difference, "Difference"}};
+
+LayerPropertiesDialog::LayerPropertiesDialog(const QString &name, qreal opacity, QPainter::CompositionMode blend_mode, QWidget *parent) : QDialog(parent),
+                                                                                                                                        ui(new Ui::LayerPropertiesDialog) {
+  ui->setupUi(this);
+
+  for (auto m : kBlendModeOptions) {
+    ui->blend_mode_comboBox->addItem(m.second);
+    if (m.first == blend_mode) {
+      ui->blend_mode_comboBox->setCurrentIndex(ui->blend_mode_comboBox->count() - 1);
+    }
+  }
+
+  ui->name_lineEdit->setText(name);
+  ui->opacity_spinBox->setValue(qRound(opacity * 100));
+}
+
+LayerPropertiesDialog::~LayerPropertiesDialog() {
+  delete ui;
+}
+
+QString LayerPropertiesDialog::name() const {
+  return ui->name_lineEdit->text();
+}
+
+qreal LayerPropertiesDialog::opacity() const {
+  return ui->opacity_spinBox->value() / 100.0;
+}
+
+QPainter::CompositionMode LayerPropertiesDialog::blend_mode() const {
+  return kBlendModeOptions[ui->blend_mode_comboBox->currentIndex()].first;
+}
@@ -0,0 +1,45 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef LAYER_PROPERTIES_DIALOG_H
+#define LAYER_PROPERTIES_DIALOG_H
+
+#include <QDialog>
+#include <QPainter>
+
+namespace Ui {
+class LayerPropertiesDialog;
+}
+
+class LayerPropertiesDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  LayerPropertiesDialog(const QString &name, qreal opacity, QPainter::CompositionMode blend_mode, QWidget *parent = 0);
+  ~LayerPropertiesDialog();
+
+  QString name() const;
+  qreal opacity() const;
+  QPainter::CompositionMode blend_mode() const;
+
+private:
+  Ui::LayerPropertiesDialog *ui;
+};
+
+#endif // LAYER_PROPERTIES_DIALOG_H
@@ -28,6 +28,10 @@
 #include "utils/debug.h"
 #include "widgets/color_palette_widget.h"
 #include "widgets/image_canvas_container.h"
+#include "widgets/image_canvas_widget.h"
+#include "widgets/navigator_widget.h"
+#include "widgets/animation_preview_widget.h"
+#include "widgets/voxel_preview_widget.h"
 
 #include <QCloseEvent>
 #include <QMenu>
@@ -44,12 +48,17 @@ const QString kConfigWindowMaximized = "Maximized";
 const bool kConfigWindowMaximizedDefault = false;
 const QRect kConfigDefaultWindowGeometry = QRect(50, 50, 800, 600);
 
+// Documents not activated for this long are compressed away.
+const int kHibernateAfterMinutes = 5;
+const int kHibernationCheckInterval = 60 * 1000;
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow),
       action_handler_(new ActionHandler(this)),
       current_canvas_container_(nullptr),
-      options_cache_(pApp->options()) {
+      options_cache_(pApp->options()),
+      hibernation_timer_(new QTimer(this)) {
   ui->setupUi(this);
 
   LoadSettings();
@@ -63,6 +72,9 @@ MainWindow::MainWindow(QWidget *parent)
   ConnectWidgets();
   SetToolButtons();
 
+  QObject::connect(hibernation_timer_, SIGNAL(timeout()), this, SLOT(HibernateIdleCanvas()));
+  hibernation_timer_->start(kHibernationCheckInterval);
+
   QTimer::singleShot(0, this, SLOT(PostLoadInit()));
 }
 
@@ -70,6 +82,12 @@ void MainWindow::PostLoadInit() {
   UpdateWidgetState();
 }
 
+void MainWindow::HibernateIdleCanvas() {
+  for (ImageCanvasWidget *canvas : *ImageCanvasWidget::open_canvas()) {
+    canvas->HibernateIfIdle(qint64(kHibernateAfterMinutes) * 60 * 1000);
+  }
+}
+
 MainWindow::~MainWindow() {
   delete ui;
 }
@@ -139,16 +157,51 @@ void MainWindow::ConnectActions() {
   QObject::connect(ui->actionTransparency, SIGNAL(triggered(bool)), action_handler_, SLOT(ToggleTransparency(bool)));
   QObject::connect(ui->zoom_horizontalSlider, SIGNAL(valueChanged(int)), action_handler_, SLOT(Zoom(int)));
   QObject::connect(ui->actionLoad_Palette, SIGNAL(triggered(bool)), action_handler_, SLOT(LoadPalette()));
+  QObject::connect(ui->actionPalette_From_Image, SIGNAL(triggered(bool)), action_handler_, SLOT(PaletteFromImage()));
   QObject::connect(ui->actionSave_Palette, SIGNAL(triggered(bool)), action_handler_, SLOT(SavePalette()));
   QObject::connect(ui->actionDefault_Palette, SIGNAL(triggered(bool)), action_handler_, SLOT(DefaultPalette()));
   QObject::connect(ui->actionShow_Grid, SIGNAL(triggered(bool)), action_handler_, SLOT(ToggleShowGrid(bool)));
   QObject::connect(ui->actionShow_Pixel_Grid, SIGNAL(triggered(bool)), action_handler_, SLOT(ToggleShowPixelGrid(bool)));
+  ui->menuView->addAction(ui->navigator_dockWidget->toggleViewAction());
+  ui->menuView->addAction(ui->animation_dockWidget->toggleViewAction());
+  ui->menuView->addAction(ui->voxel_dockWidget->toggleViewAction());
   QObject::connect(ui->actionCopy, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(Copy()));
   QObject::connect(ui->actionCut, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(Cut()));
   QObject::connect(ui->actionPaste, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(Paste()));
   QObject::connect(ui->actionDelete, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(Delete()));
   QObject::connect(ui->actionSelect_All, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(SelectAll()));
+  QObject::connect(ui->actionAuto_Mask, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(AutoMask()));
+  QObject::connect(ui->actionClear_Mask, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(ClearMask()));
+  QObject::connect(ui->actionInvert_Mask, SIGNAL(triggered(bool)), ui->edit_widget, SLOT(InvertMask()));
   QObject::connect(ui->actionImage_Size, SIGNAL(triggered(bool)), action_handler_, SLOT(ImageSize()));
+  QObject::connect(ui->actionZoom_Image_2x, SIGNAL(triggered(bool)), action_handler_, SLOT(ZoomImage2x()));
+  QObject::connect(ui->actionZoom_Image_4x, SIGNAL(triggered(bool)), action_handler_, SLOT(ZoomImage4x()));
+  QObject::connect(ui->actionCreate_Shadow, SIGNAL(triggered(bool)), action_handler_, SLOT(CreateShadow()));
+
+  // Layer Actions
+  QObject::connect(ui->actionNew_Layer, SIGNAL(triggered(bool)), action_handler_, SLOT(NewLayer()));
+  QObject::connect(ui->actionDelete_Layer, SIGNAL(triggered(bool)), action_handler_, SLOT(DeleteLayer()));
+  QObject::connect(ui->actionMove_Layer_Up, SIGNAL(triggered(bool)), action_handler_, SLOT(MoveLayerUp()));
+  QObject::connect(ui->actionMove_Layer_Down, SIGNAL(triggered(bool)), action_handler_, SLOT(MoveLayerDown()));
+  QObject::connect(ui->actionSelect_Layer_Above, SIGNAL(triggered(bool)), action_handler_, SLOT(SelectLayerAbove()));
+  QObject::connect(ui->actionSelect_Layer_Below, SIGNAL(triggered(bool)), action_handler_, SLOT(SelectLayerBelow()));
+  QObject::connect(ui->actionToggle_Layer_Visibility, SIGNAL(triggered(bool)), action_handler_, SLOT(ToggleLayerVisibility()));
+  QObject::connect(ui->actionLayer_Properties, SIGNAL(triggered(bool)), action_handler_, SLOT(LayerProperties()));
+
+  // Animation Actions
+  QObject::connect(ui->actionNew_Frame, SIGNAL(triggered(bool)), action_handler_, SLOT(NewFrame()));
+  QObject::connect(ui->actionDelete_Frame, SIGNAL(triggered(bool)), action_handler_, SLOT(DeleteFrame()));
+  QObject::connect(ui->actionPrevious_Frame, SIGNAL(triggered(bool)), action_handler_, SLOT(PreviousFrame()));
+  QObject::connect(ui->actionNext_Frame, SIGNAL(triggered(bool)), action_handler_, SLOT(NextFrame()));
+  QObject::connect(ui->actionMake_Keyframe, SIGNAL(triggered(bool)), action_handler_, SLOT(MakeKeyframe()));
+  QObject::connect(ui->actionOnion_Skin, SIGNAL(triggered(bool)), action_handler_, SLOT(ToggleOnionSkin(bool)));
+  QObject::connect(ui->actionPlay_Animation, SIGNAL(toggled(bool)), ui->animation_preview_widget, SLOT(SetPlaying(bool)));
+  QObject::connect(ui->frame_rate_spinBox, SIGNAL(valueChanged(int)), ui->animation_preview_widget, SLOT(SetFrameRate(int)));
+
+  // Voxel Actions
+  QObject::connect(ui->actionNew_Voxel_Model, SIGNAL(triggered(bool)), action_handler_, SLOT(NewVoxelModel()));
+  QObject::connect(ui->actionSlice_Above, SIGNAL(triggered(bool)), action_handler_, SLOT(SliceAbove()));
+  QObject::connect(ui->actionSlice_Below, SIGNAL(triggered(bool)), action_handler_, SLOT(SliceBelow()));
 
   // Group Tools
   QActionGroup *tool_action_group = new QActionGroup(this);
@@ -180,6 +233,7 @@ void MainWindow::ConnectActions() {
   arrow_menu->addAction(ui->actionShift_Down);
   arrow_menu->addAction(ui->actionRotate_90_CCW);
   arrow_menu->addAction(ui->actionRotate_90_CW);
+  arrow_menu->addAction(ui->actionRotate);
   arrow_menu->addAction(ui->actionFlip_Horizontal);
   arrow_menu->addAction(ui->actionFlip_Vertical);
   arrow_menu->addAction(ui->actionScale_Selection);
@@ -344,4 +398,14 @@ void MainWindow::CurrentWindowChanged(QMdiSubWindow *w) {
       current_canvas_container_->SetAsActive(ui->edit_widget);
     }
   }
+  ui->navigator_widget->SetCanvas(current_canvas_container_);
+  ui->animation_preview_widget->SetCanvas(nullptr == current_canvas_container_ ? nullptr : current_canvas_container_->GetCanvasWidget());
+  ui->voxel_preview_widget->SetCanvas(nullptr == current_canvas_container_ ? nullptr : current_canvas_container_->GetCanvasWidget());
+  ui->actionOnion_Skin->setChecked(nullptr != current_canvas_container_ && current_canvas_container_->GetCanvasWidget()->onion_skin());
+
+  QVector<QRgb> palette;
+  if (nullptr != current_canvas_container_) {
+    palette = current_canvas_container_->GetCanvasWidget()->palette();
+  }
+  ui->color_palette_widget->SetDocumentPalette(palette);
 }
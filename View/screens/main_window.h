@@ -34,7 +34,9 @@ class ImageCanvasContainer;
 class GlobalOptions;
 class ImageEditWidget;
 class ColorPaletteWidget;
+class NavigatorWidget;
 class QSlider;
+class QTimer;
 
 /*!
  * \brief The MainWindow class
@@ -65,6 +67,7 @@ private:
   ImageCanvasContainer *current_canvas_container_;
 
   GlobalOptions *options_cache_;
+  QTimer *hibernation_timer_;
 
   QRect window_geometry_;
   QRect window_geometry_aux_;
@@ -88,6 +91,7 @@ private:
 private slots:
   void CurrentWindowChanged(QMdiSubWindow *w);
   void PostLoadInit();
+  void HibernateIdleCanvas();
 };
 
 #endif // MAIN_WINDOW_H
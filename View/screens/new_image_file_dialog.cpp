@@ -38,14 +38,14 @@ const QSize kPresetOptions[] = {
     QSize(800, 600)};
 
 const QPair<QImage::Format, QString> kFormatOptions[] = {
-    // TODO(ricardo) fix the program using 8 bit images issue.
-    //{QImage::Format_Indexed8,"8 bit indexed"},
-    {QImage::Format_ARGB32_Premultiplied, "32 bit"}};
+    {QImage::Format_ARGB32_Premultiplied, "32 bit"},
+    {QImage::Format_Indexed8, "8 bit indexed"}};
 
 NewImageFileDialog::NewImageFileDialog(QWidget *parent) : QDialog(parent),
                                                           ui(new Ui::NewImageFileDialog),
                                                           selected_size_(kPresetOptions[0]),
-                                                          selected_format_(kFormatOptions[0].first) {
+                                                          selected_format_(kFormatOptions[0].first),
+                                                          selected_sparse_(false) {
   ui->setupUi(this);
 
   for (QSize s : kPresetOptions) {
@@ -84,6 +84,10 @@ QColor NewImageFileDialog::selected_color() const {
   return selected_color_;
 }
 
+bool NewImageFileDialog::selected_sparse() const {
+  return selected_sparse_;
+}
+
 void NewImageFileDialog::SetColor(const QColor &color) {
   selected_color_ = color;
   ui->color_pushButton->setStyleSheet(QString("background-color: %1; border: 1px solid black;").arg(selected_color_.name()));
@@ -122,5 +126,7 @@ void NewImageFileDialog::UpdatePresetValues(int index) {
 
 void NewImageFileDialog::UpdateGlobalNewImageSize() {
   selected_size_ = QSize(ui->width_spinBox->value(),ui->height_spinBox->value());
+  selected_format_ = kFormatOptions[ui->format_comboBox->currentIndex()].first;
+  selected_sparse_ = ui->sparse_checkBox->isChecked();
   pApp->options()->set_new_image_size(selected_size_);
 }
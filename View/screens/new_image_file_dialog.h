@@ -39,6 +39,7 @@ public:
   QSize selected_size() const;
   QImage::Format selected_format() const;
   QColor selected_color() const;
+  bool selected_sparse() const;
 
 private:
   Ui::NewImageFileDialog *ui;
@@ -46,6 +47,7 @@ private:
   QSize selected_size_;
   QColor selected_color_;
   QImage::Format selected_format_;
+  bool selected_sparse_;
 
   void SetColor(const QColor &color);
 private slots:
@@ -0,0 +1,50 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "quantize_dialog.h"
+#include "ui_quantize_dialog.h"
+
+const QPair<QUANTIZER_ENUM, QString> kQuantizerOptions[] = {
+    {QUANTIZER_MEDIAN_CUT, "Median Cut"},
+    {QUANTIZER_OCTREE, "Octree"}};
+
+QuantizeDialog::QuantizeDialog(QWidget *parent) : QDialog(parent),
+                                                  ui(new Ui::QuantizeDialog) {
+  ui->setupUi(this);
+
+  for (auto q : kQuantizerOptions) {
+    ui->quantizer_comboBox->addItem(q.second);
+  }
+}
+
+QuantizeDialog::~QuantizeDialog() {
+  delete ui;
+}
+
+QUANTIZER_ENUM QuantizeDialog::quantizer() const {
+  return kQuantizerOptions[ui->quantizer_comboBox->currentIndex()].first;
+}
+
+int QuantizeDialog::colors() const {
+  return ui->colors_spinBox->value();
+}
+
+int QuantizeDialog::kmeans_passes() const {
+  return ui->kmeans_spinBox->value();
+}
@@ -0,0 +1,49 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef QUANTIZE_DIALOG_H
+#define QUANTIZE_DIALOG_H
+
+#include <QDialog>
+
+#include "pb_quantize.h"
+
+namespace Ui {
+class QuantizeDialog;
+}
+
+/*!
+ * \brief Options of the Palette From Image action.
+ */
+class QuantizeDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit QuantizeDialog(QWidget *parent = 0);
+  ~QuantizeDialog();
+
+  QUANTIZER_ENUM quantizer() const;
+  int colors() const;
+  int kmeans_passes() const;
+
+private:
+  Ui::QuantizeDialog *ui;
+};
+
+#endif // QUANTIZE_DIALOG_H
@@ -1,13 +1,45 @@
 #include "resize_image_dialog.h"
 #include "ui_resize_image_dialog.h"
 
+#include <QButtonGroup>
+#include <QToolButton>
+
+// Anchors are numbered row by row, 4 is the center.
+const int kAnchorColumns = 3;
+const int kDefaultAnchor = 0;
+// Arrows toward the side the pixels stay against, a dot for the center.
+const ushort kAnchorGlyphs[] = {0x2196, 0x2191, 0x2197, 0x2190, 0x25cf, 0x2192, 0x2199, 0x2193, 0x2198};
+const char *const kAnchorTips[] = {
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the top left corner"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the top edge"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the top right corner"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the left edge"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the center"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the right edge"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the bottom left corner"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the bottom edge"),
+  QT_TRANSLATE_NOOP("ResizeImageDialog", "Keep the bottom right corner"),
+};
+
 ResizeImageDialog::ResizeImageDialog(const QSize &original_size, QWidget *parent)
     : QDialog(parent),
-      ui(new Ui::Resize_Image_Dialog) {
+      ui(new Ui::Resize_Image_Dialog),
+      anchor_group_(new QButtonGroup(this)),
+      original_size_(original_size) {
   ui->setupUi(this);
   ui->width_spinBox->setValue(original_size.width());
   ui->height_spinBox->setValue(original_size.height());
 
+  for (int i = 0; i < kAnchorColumns * kAnchorColumns; i++) {
+    QToolButton *button = new QToolButton(ui->anchor_groupBox);
+    button->setText(QChar(kAnchorGlyphs[i]));
+    button->setToolTip(tr(kAnchorTips[i]));
+    button->setCheckable(true);
+    button->setChecked(i == kDefaultAnchor);
+    anchor_group_->addButton(button, i);
+    ui->anchor_gridLayout->addWidget(button, i / kAnchorColumns, i % kAnchorColumns);
+  }
+
   QObject::connect(this, SIGNAL(accepted()), this, SLOT(UpdateSize()));
 }
 
@@ -19,6 +51,12 @@ QSize ResizeImageDialog::new_size() const {
   return new_size_;
 }
 
+QPoint ResizeImageDialog::offset() const {
+  int anchor = anchor_group_->checkedId();
+  QSize growth = new_size_ - original_size_;
+  return QPoint(growth.width() * (anchor % kAnchorColumns) / 2, growth.height() * (anchor / kAnchorColumns) / 2);
+}
+
 void ResizeImageDialog::UpdateSize() {
   new_size_ = QSize(ui->width_spinBox->value(),ui->height_spinBox->value());
 }
@@ -3,6 +3,8 @@
 
 #include <QDialog>
 
+class QButtonGroup;
+
 namespace Ui {
 class Resize_Image_Dialog;
 }
@@ -16,9 +18,14 @@ public:
   ~ResizeImageDialog();
 
   QSize new_size() const;
+  // Where the old pixels go, set by the anchor: 0 keeps them on the left
+  // (top) edge, the growth is split for the center anchors.
+  QPoint offset() const;
 private:
   Ui::Resize_Image_Dialog *ui;
+  QButtonGroup *anchor_group_;
 
+  QSize original_size_;
   QSize new_size_;
 
 private slots:
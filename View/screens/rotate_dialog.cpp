@@ -0,0 +1,60 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "rotate_dialog.h"
+#include "ui_rotate_dialog.h"
+
+#include "pb_scale.h"
+
+RotateDialog::RotateDialog(const QImage &source, QWidget *parent) : QDialog(parent),
+                                                                    ui(new Ui::RotateDialog),
+                                                                    source_(source) {
+  ui->setupUi(this);
+
+  QObject::connect(ui->angle_slider, SIGNAL(valueChanged(int)), ui->angle_spinBox, SLOT(setValue(int)));
+  QObject::connect(ui->angle_spinBox, SIGNAL(valueChanged(int)), ui->angle_slider, SLOT(setValue(int)));
+  QObject::connect(ui->angle_spinBox, SIGNAL(valueChanged(int)), this, SLOT(UpdatePreview()));
+  QObject::connect(ui->angle_slider, SIGNAL(sliderReleased()), this, SLOT(UpdatePreview()));
+
+  UpdatePreview();
+}
+
+RotateDialog::~RotateDialog() {
+  delete ui;
+}
+
+double RotateDialog::degrees() const {
+  return ui->angle_spinBox->value();
+}
+
+void RotateDialog::UpdatePreview() {
+  if (source_.isNull()) {
+    return;
+  }
+  QImage preview = RotatePixelArt(source_, degrees(), ui->angle_slider->isSliderDown());
+  // Pixel art is small, blow it up by whole steps while it fits.
+  // The label is not laid out yet on the first call, go by its minimum.
+  QSize room = ui->preview_label->minimumSize();
+  int factor = qMax(1, qMin(room.width() / preview.width(), room.height() / preview.height()));
+  preview = preview.scaled(preview.size() * factor);
+  if (preview.width() > room.width() || preview.height() > room.height()) {
+    preview = preview.scaled(room, Qt::KeepAspectRatio);
+  }
+  ui->preview_label->setPixmap(QPixmap::fromImage(preview));
+}
@@ -0,0 +1,52 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef ROTATE_DIALOG_H
+#define ROTATE_DIALOG_H
+
+#include <QDialog>
+#include <QImage>
+
+namespace Ui {
+class RotateDialog;
+}
+
+/*!
+ * \brief Picks an angle for RotSprite rotation, previewing it on |source|.
+ * Dragging the slider previews with the fast nearest neighbour path, the
+ * full quality preview comes back once it is released.
+ */
+class RotateDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit RotateDialog(const QImage &source, QWidget *parent = 0);
+  ~RotateDialog();
+
+  double degrees() const;
+
+private:
+  Ui::RotateDialog *ui;
+
+  QImage source_;
+private slots:
+  void UpdatePreview();
+};
+
+#endif // ROTATE_DIALOG_H
@@ -0,0 +1,48 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "scale_selection_dialog.h"
+#include "ui_scale_selection_dialog.h"
+
+const QPair<SCALER_ENUM, QString> kScalerOptions[] = {
+    {SCALER_NEAREST, "Nearest Neighbour"},
+    {SCALER_SCALE_NX, "Scale2x / Scale3x"},
+    {SCALER_HQX, "hqx"},
+    {SCALER_XBR, "xBR"}};
+
+ScaleSelectionDialog::ScaleSelectionDialog(QWidget *parent) : QDialog(parent),
+                                                              ui(new Ui::ScaleSelectionDialog) {
+  ui->setupUi(this);
+
+  for (auto s : kScalerOptions) {
+    ui->scaler_comboBox->addItem(s.second);
+  }
+}
+
+ScaleSelectionDialog::~ScaleSelectionDialog() {
+  delete ui;
+}
+
+SCALER_ENUM ScaleSelectionDialog::scaler() const {
+  return kScalerOptions[ui->scaler_comboBox->currentIndex()].first;
+}
+
+int ScaleSelectionDialog::factor() const {
+  return ui->factor_spinBox->value();
+}
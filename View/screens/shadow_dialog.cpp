@@ -0,0 +1,67 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "shadow_dialog.h"
+#include "ui_shadow_dialog.h"
+
+#include "application/pixel_booster.h"
+#include "widgets/color_dialog.h"
+
+const QString kTxtShadowColorDialogTitle = "Select shadow color";
+
+ShadowDialog::ShadowDialog(QWidget *parent) : QDialog(parent),
+                                              ui(new Ui::ShadowDialog) {
+  ui->setupUi(this);
+
+  QObject::connect(ui->color_pushButton, SIGNAL(clicked()), this, SLOT(ColorButtonClicked()));
+
+  SetColor(pApp->options()->main_color());
+}
+
+ShadowDialog::~ShadowDialog() {
+  delete ui;
+}
+
+QPoint ShadowDialog::offset() const {
+  return QPoint(ui->offset_x_spinBox->value(), ui->offset_y_spinBox->value());
+}
+
+int ShadowDialog::radius() const {
+  return ui->radius_spinBox->value();
+}
+
+QColor ShadowDialog::color() const {
+  return color_;
+}
+
+bool ShadowDialog::whole_sheet() const {
+  return ui->whole_sheet_checkBox->isChecked();
+}
+
+void ShadowDialog::SetColor(const QColor &color) {
+  color_ = color;
+  ui->color_pushButton->setStyleSheet(QString("background-color: %1; border: 1px solid black;").arg(color_.name()));
+}
+
+void ShadowDialog::ColorButtonClicked() {
+  QColor color = ColorDialog::GetColor(color_, this, kTxtShadowColorDialogTitle);
+  if (color.isValid()) {
+    SetColor(color);
+  }
+}
@@ -0,0 +1,55 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef SHADOW_DIALOG_H
+#define SHADOW_DIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class ShadowDialog;
+}
+
+/*!
+ * \brief Options of the Create Shadow action. A zero offset with a radius
+ * of 1 makes an outline.
+ */
+class ShadowDialog : public QDialog {
+  Q_OBJECT
+
+public:
+  explicit ShadowDialog(QWidget *parent = 0);
+  ~ShadowDialog();
+
+  QPoint offset() const;
+  int radius() const;
+  QColor color() const;
+  bool whole_sheet() const;
+
+private:
+  Ui::ShadowDialog *ui;
+
+  QColor color_;
+
+  void SetColor(const QColor &color);
+private slots:
+  void ColorButtonClicked();
+};
+
+#endif // SHADOW_DIALOG_H
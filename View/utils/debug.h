@@ -63,10 +63,27 @@ inline QString _DEBUG_CLEAN_FUNCTION_NAME(QString function_name) {
 #define DEBUG_ALLOCATE _DEBUG_COUNTER++;
 #define DEBUG_RELEASED _DEBUG_COUNTER++;
 
+// One count for the whole program, the other counters are per file.
+inline unsigned int &_DEBUG_CONVERSIONS() {
+  static unsigned int count = 0;
+  return count;
+}
+
+// Reports |image| reaching a hot path in another format than |expected|,
+// which costs a conversion there (often hidden inside QPainter).
+#define DEBUG_CONVERSION(image, expected)                               \
+  if ((image).format() != (expected)) {                                 \
+    DEBUG_LOG(DEBUG_TYPE_WARNING, "Format conversion"                   \
+                                      << int((image).format()) << "to"  \
+                                      << int(expected) << "total"       \
+                                      << ++_DEBUG_CONVERSIONS());       \
+  }
+
 #else
 #define DEBUG_LOG(type, msg)
 #define DEBUG_ALLOCATE
 #define DEBUG_RELEASED
+#define DEBUG_CONVERSION(image, expected)
 #endif
 
 // Different type of debug messages
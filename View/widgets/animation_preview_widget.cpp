@@ -0,0 +1,119 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "animation_preview_widget.h"
+
+#include <QPainter>
+#include <QTimer>
+
+#include "logic/animation_timeline.h"
+#include "widgets/image_canvas_widget.h"
+#include "pb_math.h"
+
+const int kDefaultFrameRate = 12;
+const int kMaxFrameRate = 60;
+
+AnimationPreviewWidget::AnimationPreviewWidget(QWidget *parent)
+    : QWidget(parent),
+      timer_(new QTimer(this)),
+      frame_(0),
+      playing_(false) {
+  setMinimumSize(64, 64);
+  timer_->setTimerType(Qt::PreciseTimer);
+  SetFrameRate(kDefaultFrameRate);
+  QObject::connect(timer_, SIGNAL(timeout()), this, SLOT(NextFrame()));
+}
+
+void AnimationPreviewWidget::SetCanvas(ImageCanvasWidget *canvas) {
+  if (!canvas_.isNull()) {
+    QObject::disconnect(canvas_, 0, this, 0);
+  }
+  canvas_ = canvas;
+  pixmaps_.clear();
+  frame_ = canvas ? canvas->current_frame() : 0;
+  if (!canvas_.isNull()) {
+    QObject::connect(canvas_, SIGNAL(ImageChanged(QRect)), this, SLOT(CanvasChanged()));
+  }
+  update();
+}
+
+void AnimationPreviewWidget::SetPlaying(bool playing) {
+  playing_ = playing;
+  if (playing_) {
+    timer_->start();
+  } else {
+    timer_->stop();
+    CanvasChanged();
+  }
+}
+
+void AnimationPreviewWidget::SetFrameRate(int fps) {
+  timer_->setInterval(1000 / clamp(fps, 1, kMaxFrameRate));
+}
+
+void AnimationPreviewWidget::NextFrame() {
+  if (canvas_.isNull()) {
+    return;
+  }
+  int count = canvas_->SyncTimeline()->size();
+  frame_ = count > 0 ? (frame_ + 1) % count : 0;
+  update();
+}
+
+void AnimationPreviewWidget::CanvasChanged() {
+  // While stopped the preview follows the frame being edited.
+  if (!playing_ && !canvas_.isNull()) {
+    frame_ = canvas_->current_frame();
+    update();
+  }
+}
+
+void AnimationPreviewWidget::paintEvent(QPaintEvent *) {
+  QPainter painter(this);
+  painter.fillRect(rect(), Qt::darkGray);
+
+  const QPixmap *pixmap = FramePixmap(frame_);
+  if (nullptr == pixmap) {
+    return;
+  }
+
+  // Whole pixel zoom, centered.
+  int scale = qMax(1, qMin(width() / pixmap->width(), height() / pixmap->height()));
+  QRect target(QPoint(), pixmap->size() * scale);
+  target.moveCenter(rect().center());
+  painter.drawPixmap(target, *pixmap);
+}
+
+const QPixmap *AnimationPreviewWidget::FramePixmap(int index) {
+  if (canvas_.isNull()) {
+    return nullptr;
+  }
+  const AnimationTimeline *timeline = canvas_->SyncTimeline();
+  if (index >= timeline->size()) {
+    return nullptr;
+  }
+
+  pixmaps_.resize(timeline->size());
+  QPair<quint64, QPixmap> &cached = pixmaps_[index];
+  if (cached.first != timeline->version(index)) {
+    cached.first = timeline->version(index);
+    cached.second = QPixmap::fromImage(timeline->frame(index).ToImage());
+  }
+  return &cached.second;
+}
@@ -0,0 +1,67 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef ANIMATION_PREVIEW_WIDGET_H
+#define ANIMATION_PREVIEW_WIDGET_H
+
+#include <QPair>
+#include <QPixmap>
+#include <QPointer>
+#include <QVector>
+#include <QWidget>
+
+class ImageCanvasWidget;
+class QTimer;
+
+/*!
+ * \brief Plays back the frames of the active canvas.
+ *
+ * Every frame is turned into a pixmap once and kept until its version
+ * changes, so a playback tick only draws one pixmap.
+ */
+class AnimationPreviewWidget : public QWidget {
+  Q_OBJECT
+public:
+  explicit AnimationPreviewWidget(QWidget *parent = 0);
+
+  void SetCanvas(ImageCanvasWidget *canvas);
+
+protected:
+  virtual void paintEvent(QPaintEvent *);
+
+private:
+  QPointer<ImageCanvasWidget> canvas_;
+  QTimer *timer_;
+  int frame_;
+  bool playing_;
+
+  QVector<QPair<quint64, QPixmap>> pixmaps_;
+
+  const QPixmap *FramePixmap(int index);
+
+public slots:
+  void SetPlaying(bool playing);
+  void SetFrameRate(int fps);
+
+private slots:
+  void NextFrame();
+  void CanvasChanged();
+};
+
+#endif // ANIMATION_PREVIEW_WIDGET_H
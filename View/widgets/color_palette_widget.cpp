@@ -24,6 +24,7 @@
 
 #include "application/pixel_booster.h"
 #include "logic/action_handler.h"
+#include "logic/indexed_color.h"
 #include "screens/main_window.h"
 
 ColorPaletteWidget::ColorPaletteWidget(QWidget *parent) : QWidget(parent) {
@@ -33,17 +34,22 @@ ColorPaletteWidget::ColorPaletteWidget(QWidget *parent) : QWidget(parent) {
 void ColorPaletteWidget::paintEvent(QPaintEvent *) {
   QPainter painter(this);
 
-  if (palette_.isNull()) {
+  const QImage &palette = shown_palette();
+  if (palette.isNull()) {
     return;
   }
 
-  painter.drawImage(rect(), palette_);
+  painter.drawImage(rect(), palette);
 }
 
 void ColorPaletteWidget::mousePressEvent(QMouseEvent *event) {
   float posx = static_cast<float>(event->pos().x()) / static_cast<float>(this->width());
   float posy = static_cast<float>(event->pos().y()) / static_cast<float>(this->height());
-  QColor color = palette_.pixel(palette_.width() * posx, palette_.height() * posy);
+  const QImage &palette = shown_palette();
+  if (palette.isNull()) {
+    return;
+  }
+  QColor color = palette.pixel(palette.width() * posx, palette.height() * posy);
   switch (event->button()) {
   case Qt::LeftButton:
     pApp->main_window()->action_handler()->SetMainColor(color);
@@ -63,3 +69,12 @@ void ColorPaletteWidget::SetPalette(const QImage &image) {
 QImage *ColorPaletteWidget::palette() {
   return &palette_;
 }
+
+void ColorPaletteWidget::SetDocumentPalette(const QVector<QRgb> &table) {
+  document_palette_ = IndexedColor::PaletteImage(table);
+  update();
+}
+
+const QImage &ColorPaletteWidget::shown_palette() const {
+  return document_palette_.isNull() ? palette_ : document_palette_;
+}
@@ -33,9 +33,15 @@ public:
 
   void SetPalette(const QImage &image);
   QImage *palette();
+  // Shows the color table of an indexed document instead of the user
+  // palette. An empty table brings the user palette back.
+  void SetDocumentPalette(const QVector<QRgb> &table);
 
 private:
   QImage palette_;
+  QImage document_palette_;
+
+  const QImage &shown_palette() const;
 signals:
 
 public slots:
@@ -20,19 +20,49 @@
 #include "image_canvas_widget.h"
 
 #include "application/pixel_booster.h"
+#include "logic/pixel_format.h"
+#include "logic/shadow_effect.h"
 #include "utils/debug.h"
+#include "pb_math.h"
 
+#include <QDateTime>
 #include <QFileDialog>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
+#include <QWheelEvent>
+#include <QtMath>
 
 QVector<ImageCanvasWidget *> ImageCanvasWidget::open_canvas_;
 
+// Document wide steps kept for undo are dropped, oldest first, past this
+// many bytes. Stored steps count what they keep in memory.
+const qint64 kDocumentHistoryBytes = 64 * 1024 * 1024;
+
+// Zoom steps of the source canvas. Below 1x the sheet is drawn from the
+// mipmap pyramid.
+const qreal kCanvasZoomLevels[] = {0.125, 0.25, 0.5, 1.0, 2.0, 3.0, 4.0, 6.0, 8.0};
+const int kCanvasZoomLevelCount = sizeof(kCanvasZoomLevels) / sizeof(kCanvasZoomLevels[0]);
+
+// Empty area shown past the right and bottom edges of a sparse document, so
+// the tile cursor can reach outside and grow it.
+const int kSparseMargin = 4 * TiledImage::kTileSize;
+
+// Longest side of the image painted for a hibernating document.
+const int kThumbnailSize = 256;
+
 ImageCanvasWidget::ImageCanvasWidget(QWidget *parent)
     : QWidget(parent),
       options_cache_(pApp->options()),
       active_(false),
       anchor_down_(false),
+      zoom_(1.0),
+      current_frame_(0),
+      frame_dirty_(false),
+      onion_skin_(false),
+      current_slice_(0),
+      slice_dirty_(false),
+      last_active_(QDateTime::currentMSecsSinceEpoch()),
       saved_state_(true) {
   setMouseTracking(true);
 
@@ -47,19 +77,495 @@ void ImageCanvasWidget::SetImage(const QImage &image) {
   if (image.isNull()) {
     return;
   }
+  hibernation_.Clear();
+
+  // Indexed images keep their format and palette, the pixmap and the pyramid
+  // go through the color table for display. Anything else is converted here
+  // once, and the layers never convert again until saved.
+  layers_.Reset(PixelFormat::ToCanonical(image));
+  document_undo_.clear();
+  document_redo_.clear();
+  timeline_.Clear();
+  current_frame_ = 0;
+  volume_ = VoxelVolume();
+  voxel_renderer_.Build(volume_);
+  RefreshLayers();
+}
 
-  if (image.format() != QImage::Format_Indexed8) {
-    image_ = image;
+void ImageCanvasWidget::SetSparseImage(const QSize &size) {
+  if (size.isEmpty()) {
+    return;
   }
-  this->setFixedSize(image_.size());
+
+  layers_.ResetSparse(size);
+  document_undo_.clear();
+  document_redo_.clear();
+  RefreshLayers();
+}
+
+bool ImageCanvasWidget::sparse() const {
+  return layers_.sparse();
 }
 
 QImage ImageCanvasWidget::image() {
-  return image_;
+  Wake();
+  return layers_.Flatten();
+}
+
+LayerStack *ImageCanvasWidget::layers() {
+  Wake();
+  return &layers_;
+}
+
+void ImageCanvasWidget::RefreshLayers() {
+  if (layers_.sparse()) {
+    // A tilemap sized document would not fit in a pixmap, paint the tiles.
+    pixmap_ = QPixmap();
+    mipmap_.Clear();
+  } else {
+    QImage composite = layers_.composite().ToImage();
+    pixmap_ = QPixmap::fromImage(composite);
+    mipmap_.Build(composite);
+  }
+  this->setFixedSize(ImageToWidget(CanvasRect()).size());
+  frame_dirty_ = !timeline_.isNull();
+  slice_dirty_ = voxel_mode();
+  update();
+  emit ImageChanged(layers_.rect());
+}
+
+void ImageCanvasWidget::ResizeImage(const QSize &size, const QPoint &offset, const QColor &fill) {
+  Wake();
+  if (timeline_.isNull() && !voxel_mode()) {
+    // The old layers share their tiles with the resized ones where whole
+    // tiles did not move.
+    PushDocumentStep(layers_, false);
+  }
+  layers_.Resize(size, offset, fill);
+  RefreshLayers();
+  UnsaveState();
+}
+
+bool ImageCanvasWidget::ZoomImage(int factor) {
+  if (!timeline_.isNull() || voxel_mode()) {
+    return false;
+  }
+  Wake();
+  // The step keeps the old layers, so undo gives back every pixel written
+  // after the zoom too. They share nothing with the zoomed ones and are kept
+  // compressed.
+  PushDocumentStep(layers_, true);
+  // The display copies are rebuilt from the zoomed layers, drop them first.
+  pixmap_ = QPixmap();
+  mipmap_.Clear();
+  layers_.Zoom(factor);
+  RefreshLayers();
+  UnsaveState();
+  return true;
+}
+
+bool ImageCanvasWidget::CreateShadow(const QSize &cell, const QPoint &offset, int radius, const QColor &color) {
+  if (voxel_mode()) {
+    return false;
+  }
+  Wake();
+  // Shadowing detaches only the tiles it draws on, the rest stay shared with
+  // the copy kept for undo.
+  LayerStack before = layers_;
+  QRect dirty = ShadowEffect::ApplyToCells(&layers_, cell, offset, radius, color);
+  if (dirty.isEmpty()) {
+    return false;
+  }
+  if (timeline_.isNull()) {
+    PushDocumentStep(before, false);
+  }
+  frame_dirty_ = !timeline_.isNull();
+  RefreshPixmap(dirty);
+  UnsaveState();
+  return true;
+}
+
+qint64 ImageCanvasWidget::UndoTimestamp() const {
+  return document_undo_.isEmpty() ? 0 : document_undo_.last().timestamp;
+}
+
+qint64 ImageCanvasWidget::RedoTimestamp() const {
+  return document_redo_.isEmpty() ? 0 : document_redo_.last().timestamp;
+}
+
+void ImageCanvasWidget::Undo() {
+  if (document_undo_.isEmpty()) {
+    return;
+  }
+  Wake();
+  if (ApplyStep(&document_undo_.last())) {
+    document_redo_.push_back(document_undo_.takeLast());
+  }
+}
+
+void ImageCanvasWidget::Redo() {
+  if (document_redo_.isEmpty()) {
+    return;
+  }
+  Wake();
+  if (ApplyStep(&document_redo_.last())) {
+    document_undo_.push_back(document_redo_.takeLast());
+  }
+}
+
+void ImageCanvasWidget::PushDocumentStep(const LayerStack &layers, bool compressed) {
+  DocumentStep step = {layers, QSharedPointer<Hibernation>(), compressed, QDateTime::currentMSecsSinceEpoch()};
+  step.layers.DropCaches();
+  if (compressed) {
+    StoreStep(&step);
+  }
+  document_undo_.push_back(step);
+  document_redo_.clear();
+  TrimDocumentHistory();
+}
+
+void ImageCanvasWidget::TrimDocumentHistory() {
+  QSet<const uchar *> seen;
+  qint64 bytes = 0;
+  // The newest step is always kept.
+  for (int i = document_undo_.size() - 1; i >= 0; i--) {
+    const DocumentStep &step = document_undo_[i];
+    bytes += step.stored.isNull() ? step.layers.UnsharedBytes(&seen) : step.stored->resident_bytes();
+    if (bytes > kDocumentHistoryBytes && i < document_undo_.size() - 1) {
+      document_undo_.remove(0, i + 1);
+      return;
+    }
+  }
+}
+
+void ImageCanvasWidget::StoreStep(DocumentStep *step) {
+  if (!step->stored.isNull() || step->layers.isNull()) {
+    return;
+  }
+  QSharedPointer<Hibernation> stored(new Hibernation());
+  if (stored->Store(step->layers)) {
+    step->stored = stored;
+    step->layers = LayerStack();
+  }
+}
+
+bool ImageCanvasWidget::ApplyStep(DocumentStep *step) {
+  // Stored layers are read back with their caches built.
+  bool restored = !step->stored.isNull();
+  if (restored) {
+    if (!step->stored->Restore(&step->layers)) {
+      return false;
+    }
+    step->stored.clear();
+  }
+  pixmap_ = QPixmap();
+  mipmap_.Clear();
+  // The step keeps the layers from the other side of it.
+  qSwap(layers_, step->layers);
+  step->layers.DropCaches();
+  if (!restored) {
+    layers_.RebuildCaches();
+  }
+  if (step->compressed) {
+    StoreStep(step);
+  }
+  step->timestamp = QDateTime::currentMSecsSinceEpoch();
+  RefreshLayers();
+  UnsaveState();
+  return true;
+}
+
+void ImageCanvasWidget::SendSelection() {
+  Wake();
+  QImage selection = layers_.Copy(options_cache_->tile_selection());
+  emit SendImage(&selection);
+}
+
+const QPixmap &ImageCanvasWidget::pixmap() const {
+  return pixmap_;
+}
+
+QVector<QRgb> ImageCanvasWidget::palette() const {
+  return layers_.isNull() ? QVector<QRgb>() : layers_.layer(0).image.color_table();
+}
+
+QRect ImageCanvasWidget::image_rect() const {
+  return hibernating() ? hibernated_rect_ : layers_.rect();
+}
+
+const MipmapPyramid *ImageCanvasWidget::mipmap() const {
+  return &mipmap_;
+}
+
+void ImageCanvasWidget::DrawImageRect(QPainter *painter, const QRectF &source, const QRectF &target) const {
+  if (hibernating()) {
+    qreal sx = qreal(thumbnail_.width()) / hibernated_rect_.width();
+    qreal sy = qreal(thumbnail_.height()) / hibernated_rect_.height();
+    painter->drawImage(target, thumbnail_, QRectF(source.x() * sx, source.y() * sy, source.width() * sx, source.height() * sy));
+    return;
+  }
+  QRectF visible = source.intersected(QRectF(layers_.rect()));
+  if (visible.isEmpty()) {
+    return;
+  }
+  qreal scale_x = target.width() / source.width();
+  qreal scale_y = target.height() / source.height();
+  QRectF visible_target(target.x() + (visible.x() - source.x()) * scale_x,
+                        target.y() + (visible.y() - source.y()) * scale_y,
+                        visible.width() * scale_x, visible.height() * scale_y);
+
+  if (layers_.sparse()) {
+    const TiledImage &composite = layers_.composite();
+    QRect tiles = visible.toAlignedRect();
+    int first_column = tiles.left() / TiledImage::kTileSize;
+    int last_column = tiles.right() / TiledImage::kTileSize;
+    int first_row = tiles.top() / TiledImage::kTileSize;
+    int last_row = tiles.bottom() / TiledImage::kTileSize;
+    for (int row = first_row; row <= last_row; row++) {
+      for (int column = first_column; column <= last_column; column++) {
+        if (!composite.HasTile(column, row)) {
+          continue;
+        }
+        QRectF tile_rect = QRectF(composite.TileRect(column, row)).intersected(visible);
+        QRectF tile_target(target.x() + (tile_rect.x() - source.x()) * scale_x,
+                           target.y() + (tile_rect.y() - source.y()) * scale_y,
+                           tile_rect.width() * scale_x, tile_rect.height() * scale_y);
+        painter->drawImage(tile_target, composite.tile(column, row),
+                           tile_rect.translated(-QPointF(composite.TileRect(column, row).topLeft())));
+      }
+    }
+    return;
+  }
+
+  int level = mipmap_.LevelForScale(qMin(scale_x, scale_y));
+  if (level == 0) {
+    painter->drawPixmap(visible_target, pixmap_, visible);
+  } else {
+    qreal s = 1.0 / (1 << level);
+    QRectF level_source(visible.x() * s, visible.y() * s, visible.width() * s, visible.height() * s);
+    painter->drawImage(visible_target, mipmap_.level(level), level_source);
+  }
+}
+
+const AnimationTimeline *ImageCanvasWidget::SyncTimeline() {
+  if (frame_dirty_) {
+    StoreFrame();
+  }
+  return &timeline_;
+}
+
+int ImageCanvasWidget::current_frame() const {
+  return current_frame_;
+}
+
+void ImageCanvasWidget::ShowFrame(int index) {
+  if (timeline_.isNull() || index < 0 || index >= timeline_.size()) {
+    return;
+  }
+  if (frame_dirty_) {
+    StoreFrame();
+  }
+  current_frame_ = index;
+  layers_.Reset(timeline_.frame(index).ToImage());
+  RefreshLayers();
+  frame_dirty_ = false;
+}
+
+void ImageCanvasWidget::AddFrame() {
+  if (layers_.isNull() || layers_.sparse() || voxel_mode()) {
+    return;
+  }
+  if (timeline_.isNull()) {
+    timeline_.Reset(layers_.Flatten());
+  } else if (frame_dirty_) {
+    StoreFrame();
+  }
+  timeline_.InsertFrame(current_frame_ + 1, timeline_.frame(current_frame_).ToImage());
+  ShowFrame(current_frame_ + 1);
+  UnsaveState();
+}
+
+void ImageCanvasWidget::DeleteFrame() {
+  if (timeline_.size() <= 1) {
+    return;
+  }
+  timeline_.RemoveFrame(current_frame_);
+  current_frame_ = qMin(current_frame_, timeline_.size() - 1);
+  layers_.Reset(timeline_.frame(current_frame_).ToImage());
+  RefreshLayers();
+  // The removed frame must not be stored over its neighbour.
+  frame_dirty_ = false;
+  UnsaveState();
+}
+
+void ImageCanvasWidget::MakeKeyframe() {
+  if (!timeline_.isNull()) {
+    if (frame_dirty_) {
+      StoreFrame();
+    }
+    timeline_.MakeKeyframe(current_frame_);
+  }
+}
+
+bool ImageCanvasWidget::onion_skin() const {
+  return onion_skin_;
+}
+
+void ImageCanvasWidget::set_onion_skin(bool onion_skin) {
+  onion_skin_ = onion_skin;
+  update();
+}
+
+void ImageCanvasWidget::SetVoxelModel(const QSize &size, int depth) {
+  if (size.isEmpty() || depth <= 0) {
+    return;
+  }
+  timeline_.Clear();
+  current_frame_ = 0;
+  document_undo_.clear();
+  document_redo_.clear();
+  volume_ = VoxelVolume(size.width(), size.height(), depth);
+  voxel_renderer_.Build(volume_);
+  current_slice_ = 0;
+  layers_.Reset(volume_.Slice(0));
+  RefreshLayers();
+  slice_dirty_ = false;
+}
+
+bool ImageCanvasWidget::voxel_mode() const {
+  return !volume_.isNull();
+}
+
+int ImageCanvasWidget::current_slice() const {
+  return current_slice_;
+}
+
+int ImageCanvasWidget::slice_count() const {
+  return volume_.depth();
+}
+
+void ImageCanvasWidget::ShowSlice(int z) {
+  if (!voxel_mode() || z < 0 || z >= volume_.depth()) {
+    return;
+  }
+  if (slice_dirty_) {
+    StoreSlice();
+  }
+  current_slice_ = z;
+  layers_.Reset(volume_.Slice(z));
+  RefreshLayers();
+  slice_dirty_ = false;
+}
+
+const QImage &ImageCanvasWidget::VoxelPreview() {
+  if (slice_dirty_) {
+    StoreSlice();
+  }
+  return voxel_renderer_.image();
+}
+
+qreal ImageCanvasWidget::zoom() const {
+  return zoom_;
+}
+
+void ImageCanvasWidget::set_zoom(qreal zoom) {
+  zoom = clamp(zoom, kCanvasZoomLevels[0], kCanvasZoomLevels[kCanvasZoomLevelCount - 1]);
+  if (zoom == zoom_) {
+    return;
+  }
+  zoom_ = zoom;
+  this->setFixedSize(ImageToWidget(CanvasRect()).size());
+  update();
+  emit ZoomChanged(zoom_);
+}
+
+void ImageCanvasWidget::ZoomIn() {
+  for (qreal z : kCanvasZoomLevels) {
+    if (z > zoom_) {
+      set_zoom(z);
+      return;
+    }
+  }
+}
+
+void ImageCanvasWidget::ZoomOut() {
+  for (int i = kCanvasZoomLevelCount - 1; i >= 0; i--) {
+    if (kCanvasZoomLevels[i] < zoom_) {
+      set_zoom(kCanvasZoomLevels[i]);
+      return;
+    }
+  }
+}
+
+QPoint ImageCanvasWidget::WidgetToImage(const QPoint &pos) const {
+  return QPoint(qFloor(pos.x() / zoom_), qFloor(pos.y() / zoom_));
+}
+
+QRect ImageCanvasWidget::WidgetToImage(const QRect &rect) const {
+  return QRect(WidgetToImage(rect.topLeft()), WidgetToImage(rect.bottomRight()));
+}
+
+QRect ImageCanvasWidget::ImageToWidget(const QRect &rect) const {
+  QPoint top_left(qFloor(rect.left() * zoom_), qFloor(rect.top() * zoom_));
+  QPoint bottom_right(qCeil((rect.right() + 1) * zoom_) - 1, qCeil((rect.bottom() + 1) * zoom_) - 1);
+  return QRect(top_left, bottom_right);
 }
 
 void ImageCanvasWidget::set_active(bool active) {
   active_ = active;
+  if (active_) {
+    Wake();
+  } else {
+    last_active_ = QDateTime::currentMSecsSinceEpoch();
+  }
+}
+
+void ImageCanvasWidget::Hibernate() {
+  if (active_ || hibernating() || layers_.isNull()) {
+    return;
+  }
+  if (frame_dirty_) {
+    StoreFrame();
+  }
+  if (slice_dirty_) {
+    StoreSlice();
+  }
+
+  QSize thumbnail_size = layers_.size();
+  if (thumbnail_size.width() > kThumbnailSize || thumbnail_size.height() > kThumbnailSize) {
+    thumbnail_size.scale(kThumbnailSize, kThumbnailSize, Qt::KeepAspectRatio);
+  }
+  QImage thumbnail(thumbnail_size.expandedTo(QSize(1, 1)), QImage::Format_ARGB32_Premultiplied);
+  thumbnail.fill(0x0);
+  QPainter painter(&thumbnail);
+  DrawImageRect(&painter, QRectF(layers_.rect()), QRectF(thumbnail.rect()));
+  painter.end();
+
+  if (!hibernation_.Store(layers_)) {
+    return;
+  }
+  for (DocumentStep &step : document_undo_) {
+    StoreStep(&step);
+  }
+  for (DocumentStep &step : document_redo_) {
+    StoreStep(&step);
+  }
+  thumbnail_ = thumbnail;
+  hibernated_rect_ = layers_.rect();
+  layers_ = LayerStack();
+  pixmap_ = QPixmap();
+  mipmap_.Clear();
+  update();
+}
+
+void ImageCanvasWidget::HibernateIfIdle(qint64 idle_msecs) {
+  if (!active_ && QDateTime::currentMSecsSinceEpoch() - last_active_ >= idle_msecs) {
+    Hibernate();
+  }
+}
+
+bool ImageCanvasWidget::hibernating() const {
+  return !hibernation_.isNull();
 }
 
 QVector<ImageCanvasWidget *> *ImageCanvasWidget::open_canvas() {
@@ -85,7 +591,7 @@ void ImageCanvasWidget::Save() {
   if (image_path_.isEmpty()) {
     SaveAs();
   } else {
-    bool ok = image_.save(image_path_);
+    bool ok = PixelFormat::ForSaving(DocumentImage()).save(image_path_);
     if (ok) {
       SaveState();
     }
@@ -96,7 +602,7 @@ void ImageCanvasWidget::SaveAs() {
   QString output = QFileDialog::getSaveFileName(reinterpret_cast<QWidget *>(pApp->main_window()),
                                                 tr("Save image file as..."), ".", "PNG (*.png);;BMP (*.bmp);;JPG (*.jpg);;JPEG (*.jpeg);;GIF (*.gif);;GIF (*.gif);;PBM (*.pbm);;PGM (*.pgm);;PPM (*.ppm);;TIFF (*.tiff);;XBM (*.xbm);;XPM (*.xpm)");
   if (!output.isEmpty()) {
-    bool ok = image_.save(output);
+    bool ok = PixelFormat::ForSaving(DocumentImage()).save(output);
     if (ok) {
       image_path_ = output;
       emit PathChaged(image_path_);
@@ -114,15 +620,38 @@ void ImageCanvasWidget::set_image_path(const QString &path) {
   image_path_ = path;
 }
 
-void ImageCanvasWidget::paintEvent(QPaintEvent *) {
+void ImageCanvasWidget::paintEvent(QPaintEvent *event) {
   QPainter painter(this);
 
-  if (image_.isNull())
+  if (hibernating()) {
+    QRect source = WidgetToImage(event->rect()).intersected(hibernated_rect_);
+    DrawImageRect(&painter, QRectF(source), QRectF(ImageToWidget(source)));
+    return;
+  }
+
+  if (layers_.isNull())
     return;
-  painter.drawImage(image_.rect(), image_);
+
+  // Only the exposed area is drawn: the part of the sheet visible through the
+  // scroll area, or just the tile cursor trail while the mouse moves.
+  QRect source = WidgetToImage(event->rect()).intersected(layers_.rect());
+  if (!source.isEmpty()) {
+    DrawImageRect(&painter, QRectF(source), QRectF(ImageToWidget(source)));
+  }
+
+  if (onion_skin_ && timeline_.size() > 1 && !source.isEmpty()) {
+    QImage onion = timeline_.OnionSkin(current_frame_);
+    painter.drawImage(QRectF(ImageToWidget(source)), onion, QRectF(source));
+  }
+
+  if (layers_.sparse()) {
+    painter.setPen(Qt::darkGray);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(ImageToWidget(layers_.rect()));
+  }
 
   if (active_) {
-    QRect selection = options_cache_->tile_selection().adjusted(0, 0, -1, -1);
+    QRect selection = ImageToWidget(options_cache_->tile_selection()).adjusted(0, 0, -1, -1);
 
     if (underMouse()) {
       painter.setPen(Qt::yellow);
@@ -142,11 +671,12 @@ void ImageCanvasWidget::paintEvent(QPaintEvent *) {
 
 void ImageCanvasWidget::mousePressEvent(QMouseEvent *event) {
   if (event->button() == Qt::RightButton) {
+    QRect previous = options_cache_->tile_selection();
     options_cache_->CleanCursorShift();
     anchor_down_ = true;
-    anchor_ = options_cache_->PosToGrid(event->pos());
+    anchor_ = options_cache_->PosToGrid(event->pos(), zoom_);
     options_cache_->set_tile_selection(anchor_);
-    update();
+    RepaintTileCursor(previous);
   }
 }
 
@@ -154,8 +684,7 @@ void ImageCanvasWidget::mouseReleaseEvent(QMouseEvent *event) {
   anchor_down_ = false;
   if (event->button() == Qt::RightButton) {
     // Get image from the canvas
-    QImage selection = image_.copy(options_cache_->tile_selection());
-    emit SendImage(&selection);
+    SendSelection();
     options_cache_->UpdateCursorShift();
   } else if (event->button() == Qt::LeftButton) {
     // Set image back to the canvas
@@ -171,25 +700,70 @@ void ImageCanvasWidget::mouseMoveEvent(QMouseEvent *event) {
     pos.setY(qMin(rect().bottom() - 1, qMax(rect().top(), pos.y())));
   }
 
-  QRect current_cursor = options_cache_->PosToGrid(pos);
+  QRect previous = options_cache_->tile_selection();
+  QRect current_cursor = options_cache_->PosToGrid(pos, zoom_);
   if (anchor_down_) {
     options_cache_->set_tile_selection(current_cursor.united(anchor_));
   } else {
     options_cache_->MoveSelection(current_cursor.center());
   }
-  update();
+  RepaintTileCursor(previous);
+}
+
+void ImageCanvasWidget::wheelEvent(QWheelEvent *event) {
+  if (event->modifiers() & Qt::ControlModifier) {
+    if (event->delta() > 0) {
+      ZoomIn();
+    } else if (event->delta() < 0) {
+      ZoomOut();
+    }
+    event->accept();
+  } else {
+    event->ignore();
+  }
 }
 
 void ImageCanvasWidget::leaveEvent(QEvent *) {
-  update();
+  RepaintTileCursor(options_cache_->tile_selection());
+}
+
+void ImageCanvasWidget::RepaintTileCursor(const QRect &previous) {
+  QRect current = options_cache_->tile_selection();
+  if (previous == current && underMouse()) {
+    return;
+  }
+  // The cursor outline is drawn on the rect border, pad by the pen width.
+  update(ImageToWidget(previous.united(current)).adjusted(-1, -1, 1, 1));
+  emit TileCursorMoved();
+}
+
+void ImageCanvasWidget::RefreshPixmap(const QRect &rect) {
+  QRect r = rect.intersected(layers_.rect());
+  if (r.isEmpty()) {
+    return;
+  }
+  if (layers_.sparse()) {
+    update(ImageToWidget(r));
+    emit ImageChanged(r);
+    return;
+  }
+  // One copy of the touched tiles feeds both the pixmap and the pyramid.
+  QRect read_rect = mipmap_.ReadRect(r).united(r);
+  QImage region = layers_.composite().Copy(read_rect);
+  QPainter painter(&pixmap_);
+  painter.setCompositionMode(QPainter::CompositionMode_Source);
+  painter.drawImage(r, region, r.translated(-read_rect.topLeft()));
+  painter.end();
+  mipmap_.Update(region, read_rect.topLeft(), r);
+  update(ImageToWidget(r));
+  emit ImageChanged(r);
 }
 
 void ImageCanvasWidget::ReceiveImage(QImage *image) {
   if (nullptr == image || image->isNull()) {
     return;
   }
-  QPainter painter(&image_);
-
+  Wake();
   QRect r = options_cache_->tile_selection();
   bool m_x = r.x() < 0;
   bool m_y = r.y() < 0;
@@ -199,12 +773,75 @@ void ImageCanvasWidget::ReceiveImage(QImage *image) {
     r.moveCenter(r.center() + QPoint(m_x ? -1 : 0, m_y ? -1 : 0));
   }
 
-  if (!options_cache_->transparency_enabled()) {
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
-    painter.eraseRect(r);
+  // Only the tiles under the selection are detached and recomposited.
+  QPainter::CompositionMode mode = options_cache_->transparency_enabled() ? QPainter::CompositionMode_SourceOver : QPainter::CompositionMode_Source;
+  QSize previous_size = layers_.size();
+  QRect dirty = layers_.Draw(*image, r, mode);
+  frame_dirty_ = !timeline_.isNull();
+  slice_dirty_ = voxel_mode();
+  if (layers_.size() != previous_size) {
+    // A sparse document grew, the margin moves along with its edges.
+    this->setFixedSize(ImageToWidget(CanvasRect()).size());
+    update();
+    emit ImageChanged(layers_.rect());
+    return;
   }
+  RefreshPixmap(dirty);
+}
 
-  painter.drawImage(r, *image);
+void ImageCanvasWidget::StoreFrame() {
+  if (!timeline_.isNull()) {
+    timeline_.SetFrame(current_frame_, layers_.Flatten());
+  }
+  frame_dirty_ = false;
+}
 
-  update();
+void ImageCanvasWidget::StoreSlice() {
+  if (voxel_mode()) {
+    // Only the columns that changed are encoded and drawn again.
+    QRect changed = volume_.SetSlice(current_slice_, layers_.Flatten());
+    voxel_renderer_.Update(volume_, changed);
+  }
+  slice_dirty_ = false;
+}
+
+QImage ImageCanvasWidget::DocumentImage() {
+  Wake();
+  if (!voxel_mode()) {
+    return layers_.Flatten();
+  }
+  if (slice_dirty_) {
+    StoreSlice();
+  }
+  QImage sheet(volume_.width(), volume_.height() * volume_.depth(), QImage::Format_ARGB32_Premultiplied);
+  sheet.fill(0x0);
+  QPainter painter(&sheet);
+  for (int z = 0; z < volume_.depth(); z++) {
+    painter.drawImage(0, z * volume_.height(), volume_.Slice(z));
+  }
+  painter.end();
+  return sheet;
+}
+
+void ImageCanvasWidget::Wake() {
+  if (!hibernating()) {
+    return;
+  }
+  if (hibernation_.Restore(&layers_)) {
+    thumbnail_ = QImage();
+    RefreshLayers();
+    // Hibernation stored the frame and the slice, nothing is pending.
+    frame_dirty_ = false;
+    slice_dirty_ = false;
+  }
+}
+
+QRect ImageCanvasWidget::CanvasRect() const {
+  if (hibernating()) {
+    return hibernated_rect_;
+  }
+  if (layers_.sparse()) {
+    return layers_.rect().adjusted(0, 0, kSparseMargin, kSparseMargin);
+  }
+  return layers_.rect();
 }
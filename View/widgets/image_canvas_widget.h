@@ -20,9 +20,19 @@
 #ifndef IMAGE_CANVAS_WIDGET_H
 #define IMAGE_CANVAS_WIDGET_H
 
+#include <QPixmap>
+#include <QSharedPointer>
 #include <QWidget>
 
+#include "logic/animation_timeline.h"
+#include "logic/hibernation.h"
+#include "logic/mipmap_pyramid.h"
+#include "logic/voxel_renderer.h"
+#include "logic/voxel_volume.h"
+#include "logic/layer_stack.h"
+
 class GlobalOptions;
+class QPainter;
 
 /*!
  * \brief The ImageCanvasWidget class
@@ -34,10 +44,80 @@ class ImageCanvasWidget : public QWidget {
   virtual ~ImageCanvasWidget();
 
   void SetImage(const QImage &image);
+  // Starts an empty sparse document that grows as tiles are drawn past its
+  // right and bottom edges.
+  void SetSparseImage(const QSize &size);
+  bool sparse() const;
   QImage image();
+  LayerStack *layers();
+  // Rebuilds the display after the layer stack changed as a whole.
+  void RefreshLayers();
+  // Canvas resize, the pixels move by |offset|. Undoable on still images.
+  void ResizeImage(const QSize &size, const QPoint &offset, const QColor &fill);
+  // Scales the whole document up by |factor| (2 or 4). Still documents only,
+  // returns false for animations and voxel models.
+  bool ZoomImage(int factor);
+  // Shadows every |cell| sized tile of the active layer on its own. Returns
+  // false when nothing changed, undoable on still images.
+  bool CreateShadow(const QSize &cell, const QPoint &offset, int radius, const QColor &color);
+  // History of document wide steps (zooms, resizes, shadows). The editor
+  // keeps its own, the timestamps tell which one holds the latest step.
+  qint64 UndoTimestamp() const;
+  qint64 RedoTimestamp() const;
+  void Undo();
+  void Redo();
+  // Sends the part of the active layer under the tile cursor to the editor.
+  void SendSelection();
+  const QPixmap &pixmap() const;
+  // Color table of an indexed document, empty otherwise.
+  QVector<QRgb> palette() const;
+  QRect image_rect() const;
+  const MipmapPyramid *mipmap() const;
+  // Draws the |source| part of the composite scaled into |target|, from the
+  // pixmap or the pyramid, or straight from the allocated tiles when sparse.
+  void DrawImageRect(QPainter *painter, const QRectF &source, const QRectF &target) const;
+
+  // Frames of the document, with the edits to the shown frame stored in.
+  // Empty until the first frame is added.
+  const AnimationTimeline *SyncTimeline();
+  int current_frame() const;
+  // Stores the shown frame and loads |index|, flattening the layers.
+  void ShowFrame(int index);
+  // Adds a copy of the shown frame after it and shows the copy.
+  void AddFrame();
+  void DeleteFrame();
+  void MakeKeyframe();
+  bool onion_skin() const;
+  void set_onion_skin(bool onion_skin);
+
+  // Voxel mode: the canvas shows one z slice of a voxel model at a time.
+  void SetVoxelModel(const QSize &size, int depth);
+  bool voxel_mode() const;
+  int current_slice() const;
+  int slice_count() const;
+  // Stores the shown slice and loads |z|.
+  void ShowSlice(int z);
+  // Isometric view of the model, with the edits to the shown slice.
+  const QImage &VoxelPreview();
+
+  qreal zoom() const;
+  void set_zoom(qreal zoom);
+  void ZoomIn();
+  void ZoomOut();
+
+  QPoint WidgetToImage(const QPoint &pos) const;
+  QRect WidgetToImage(const QRect &rect) const;
+  QRect ImageToWidget(const QRect &rect) const;
 
   void set_active(bool active);
 
+  // Compresses the layers away and keeps a thumbnail to paint, unless the
+  // canvas is active. Any access to the layers restores them.
+  void Hibernate();
+  // Hibernates if the canvas was not active for |idle_msecs|.
+  void HibernateIfIdle(qint64 idle_msecs);
+  bool hibernating() const;
+
   static QVector<ImageCanvasWidget *> *open_canvas();
 
   bool saved_state() const;
@@ -54,6 +134,7 @@ class ImageCanvasWidget : public QWidget {
   virtual void mousePressEvent(QMouseEvent *event);
   virtual void mouseReleaseEvent(QMouseEvent *event);
   virtual void mouseMoveEvent(QMouseEvent *event);
+  virtual void wheelEvent(QWheelEvent *event);
   virtual void leaveEvent(QEvent *);
 
  private:
@@ -61,8 +142,38 @@ class ImageCanvasWidget : public QWidget {
 
   bool active_;
   bool anchor_down_;
-
-  QImage image_;
+  qreal zoom_;
+
+  LayerStack layers_;
+  // Display copy of the layer composite, refreshed only where pixels change.
+  QPixmap pixmap_;
+  MipmapPyramid mipmap_;
+  AnimationTimeline timeline_;
+  int current_frame_;
+  // The shown frame was drawn on since it was stored in the timeline.
+  bool frame_dirty_;
+  bool onion_skin_;
+  VoxelVolume volume_;
+  VoxelRenderer voxel_renderer_;
+  int current_slice_;
+  bool slice_dirty_;
+  Hibernation hibernation_;
+  QImage thumbnail_;
+  QRect hibernated_rect_;
+  qint64 last_active_;
+  // A document wide step (a zoom, a resize or a shadow) with the time it was
+  // applied or undone, and the layers from the other side of it. Hibernating
+  // stores every step.
+  struct DocumentStep {
+    LayerStack layers;
+    // Holds the layers compressed, or spilled to disk, while not null.
+    QSharedPointer<Hibernation> stored;
+    // Both sides share no tile (a zoom), the layers are stored between uses.
+    bool compressed;
+    qint64 timestamp;
+  };
+  QVector<DocumentStep> document_undo_;
+  QVector<DocumentStep> document_redo_;
   QString image_path_;
   QRect anchor_;
   //QRect cursor_;
@@ -72,12 +183,35 @@ class ImageCanvasWidget : public QWidget {
   static QVector<ImageCanvasWidget *> open_canvas_;
 
   void SaveState();
+  void RepaintTileCursor(const QRect &previous);
+  void RefreshPixmap(const QRect &rect);
+  void StoreFrame();
+  void StoreSlice();
+  void Wake();
+  // Keeps |layers|, without their caches, as the step before a document wide
+  // change.
+  void PushDocumentStep(const LayerStack &layers, bool compressed);
+  // Drops the oldest steps past kDocumentHistoryBytes.
+  void TrimDocumentHistory();
+  // Compresses the layers of |step| into its storage.
+  void StoreStep(DocumentStep *step);
+  // Undoes or redoes |step|, leaving in it what redoes or undoes it back.
+  // Returns false, leaving everything alone, if stored layers can't be read.
+  bool ApplyStep(DocumentStep *step);
+  // What gets saved: the flattened layers, or the slices of a voxel model in
+  // a vertical strip, z = 0 on top.
+  QImage DocumentImage();
+  // Widget area: the document, plus a drawable margin when sparse.
+  QRect CanvasRect() const;
 
  signals:
   void SendImage(QImage *);
   void RequestImage();
   void UnsavedChanges(bool);
   void PathChaged(QString);
+  void ImageChanged(QRect);
+  void TileCursorMoved();
+  void ZoomChanged(qreal);
 
  private slots:
   void ReceiveImage(QImage *image);
@@ -22,10 +22,14 @@
 #include <QClipboard>
 #include <QMouseEvent>
 #include <QPainter>
-#include <QStatusBar>
+#include <QTimer>
 
 #include "application/pixel_booster.h"
 #include "logic/action_handler.h"
+#include "logic/image_mime_data.h"
+#include "logic/indexed_color.h"
+#include "logic/pixel_format.h"
+#include "logic/shadow_effect.h"
 #include "logic/tool/ellipse_tool.h"
 #include "logic/tool/flood_fill_tool.h"
 #include "logic/tool/line_tool.h"
@@ -35,17 +39,29 @@
 #include "logic/tool/zoom_tool.h"
 #include "screens/main_window.h"
 #include "utils/debug.h"
+#include "pb_image.h"
+#include "pb_scale.h"
 #include "pb_math.h"
 
+// Mouse moves are drained once per display frame (~60 Hz).
+const int kFrameInterval = 16;
+
+// Tint drawn over protected pixels.
+const QRgb kMaskColor = qRgba(255, 0, 255, 96);
+
 ImageEditWidget::ImageEditWidget(QWidget *parent)
     : QWidget(parent),
       press_right_inside_(false),
       press_left_inside_(false),
       left_button_down_(false),
       right_button_down_(false),
-      action_started_(false) {
+      action_started_(false),
+      mask_empty_(true),
+      frame_timer_(new QTimer(this)) {
   setMouseTracking(true);
-  image_ = QImage(0, 0, QImage::Format_ARGB32_Premultiplied);
+  frame_timer_->setInterval(kFrameInterval);
+  QObject::connect(frame_timer_, SIGNAL(timeout()), this, SLOT(FlushPendingMoves()));
+  image_ = QImage(0, 0, PixelFormat::kTrueColor);
   overlay_image_ = QImage(image_.size(), image_.format());
   overlay_image_.fill(0x0);
   options_cache_ = pApp->options();
@@ -55,7 +71,7 @@ ImageEditWidget::ImageEditWidget(QWidget *parent)
 }
 
 void ImageEditWidget::Clear(const QSize &size) {
-  image_ = QImage(size, QImage::Format_ARGB32_Premultiplied);
+  image_ = QImage(size, PixelFormat::kTrueColor);
   overlay_image_ = QImage(image_.size(), image_.format());
   overlay_image_.fill(0x0);
   image_.fill(Qt::white);
@@ -64,102 +80,183 @@ void ImageEditWidget::Clear(const QSize &size) {
 }
 
 void ImageEditWidget::Undo() {
-  QImage img = undo_redo_.Undo(image_);
-  if (!img.isNull()) {
-    if (image_.size() != img.size()) {
-      image_.scaled(img.size());
+  if (undo_redo_.Undo(&image_)) {
+    // The restored state holds the lifted pixels where they were.
+    selection_ = QRect();
+    floating_ = FloatingSelection();
+    if (mask_.size() != image_.size()) {
+      ClearMask();
     }
-    image_ = img;
     UpdateWidget();
   }
 }
 
 void ImageEditWidget::Redo() {
-  QImage img = undo_redo_.Redo(image_);
-  if (!img.isNull()) {
-    image_ = img;
+  if (undo_redo_.Redo(&image_)) {
+    selection_ = QRect();
+    floating_ = FloatingSelection();
+    if (mask_.size() != image_.size()) {
+      ClearMask();
+    }
     UpdateWidget();
   }
 }
 
+qint64 ImageEditWidget::UndoTimestamp() const {
+  return undo_redo_.UndoTimestamp();
+}
+
+qint64 ImageEditWidget::RedoTimestamp() const {
+  return undo_redo_.RedoTimestamp();
+}
+
 void ImageEditWidget::set_scroll_area(QScrollArea *scroll_area) {
   scroll_area_ = scroll_area;
 }
 
 void ImageEditWidget::ClearSelection() {
-  SelectionTool::ClearSelection(&image_, &selection_, &image_selection_);
+  PutSelectionDown();
   zoom_area_ = QRect();
   repaint();
 }
 
 void ImageEditWidget::Rotate(bool cw) {
-  QTransform t;
-  t.rotate(cw?90:-90);
   if(selection_.isValid()){
-    QImage i = QImage(image_selection_.height(),image_selection_.width(),image_selection_.format());
-    QPainter p(&i);
-    p.drawImage(i.rect(),image_selection_.transformed(t));
-    image_selection_ = i;
+    floating_.Replace(RotateQuarter(floating_.ToImage(), cw));
     QPoint c = selection_.center();
     selection_.setSize(QSize(selection_.height(),selection_.width()));
     selection_.moveCenter(c);
   }else{
-    QImage i = QImage(image_.height(),image_.width(),image_.format());
-    QPainter p(&i);
-    p.drawImage(i.rect(),image_.transformed(t));
+    QImage i = RotateQuarter(image_, cw);
     GetImage(&i);
     options_cache_->set_tile_selection(QRect(QPoint(),i.size()));
   }
   repaint();
 }
 
+void ImageEditWidget::RotateBy(double degrees) {
+  if (selection_.isValid()) {
+    QImage pixels = RotatePixelArt(floating_.ToImage(), degrees);
+    floating_.Replace(pixels);
+    QPoint c = selection_.center();
+    selection_.setSize(pixels.size());
+    selection_.moveCenter(c);
+  } else {
+    QImage i = RotatePixelArt(image_, degrees);
+    QRect r(QPoint(), image_.size());
+    r.moveCenter(i.rect().center());
+    undo_redo_.Do(image_);
+    image_ = i.copy(r);
+  }
+  repaint();
+}
+
+QImage ImageEditWidget::selected_pixels() const {
+  return selection_.isValid() ? floating_.ToImage() : image_;
+}
+
 void ImageEditWidget::Flip(bool h, bool v) {
   if(selection_.isValid()){
-    image_selection_ = image_selection_.mirrored(h,v);
+    // Lifting the selection was recorded already.
+    QImage pixels = floating_.ToImage();
+    FlipInPlace(&pixels, h, v);
+    floating_.Replace(pixels);
+  }else{
+    FlipInPlace(&image_, h, v);
+    Qt::Orientations flip;
+    if (h) {
+      flip |= Qt::Horizontal;
+    }
+    if (v) {
+      flip |= Qt::Vertical;
+    }
+    undo_redo_.DoFlip(flip);
+  }
+  repaint();
+}
+
+void ImageEditWidget::Shift(int dx, int dy) {
+  if (selection_.isValid()) {
+    QImage pixels = floating_.ToImage();
+    ShiftInPlace(&pixels, dx, dy);
+    floating_.Replace(pixels);
+  } else {
+    ShiftInPlace(&image_, dx, dy);
+    undo_redo_.DoShift(QPoint(dx, dy));
+  }
+  // Held keys repeat faster than a large image repaints, let them coalesce.
+  update();
+}
+
+void ImageEditWidget::Scale(SCALER_ENUM scaler, int factor) {
+  if(selection_.isValid()){
+    QImage pixels = ScalePixelArt(floating_.ToImage(), scaler, factor);
+    floating_.Replace(pixels);
+    selection_.setSize(pixels.size());
   }else{
-    image_ = image_.mirrored(h,v);
+    QImage i = ScalePixelArt(image_, scaler, factor);
+    GetImage(&i);
+    options_cache_->set_tile_selection(QRect(QPoint(),i.size()));
+  }
+  repaint();
+}
+
+void ImageEditWidget::CreateShadow(const QPoint &offset, int radius, const QColor &color) {
+  if (selection_.isValid()) {
+    QImage pixels = floating_.ToImage();
+    if (ShadowEffect::Apply(&pixels, offset, radius, color)) {
+      floating_.Replace(pixels);
+    }
+  } else {
+    QImage pixels = image_;
+    if (ShadowEffect::Apply(&pixels, offset, radius, color, active_mask())) {
+      undo_redo_.Do(image_);
+      image_ = pixels;
+    }
   }
   repaint();
 }
 
 void ImageEditWidget::Copy() {
-  if (!image_selection_.isNull()) {
-    QApplication::clipboard()->setImage(image_selection_);
+  if (!floating_.isNull()) {
+    // Ownership goes to the clipboard, the pixels stay shared until some
+    // other application pastes them.
+    QApplication::clipboard()->setMimeData(new ImageMimeData(floating_));
   }
 }
 
 void ImageEditWidget::Cut() {
   Copy();
-  selection_ = QRect();
-  image_selection_ = QImage();
-  repaint();
+  Delete();
 }
 
 void ImageEditWidget::Paste() {
-  QImage img = QApplication::clipboard()->image();
-  if (!img.isNull()) {
-    if (!selection_.isValid()) {
-      selection_.setTopLeft(QPoint(0, 0));
-    } else {
-      QPainter p(&image_);
-      p.drawImage(selection_, image_selection_);
-    }
-    selection_.setSize(img.size());
-    image_selection_ = img;
+  // Pixels copied here come back without going through the system clipboard.
+  const ImageMimeData *own_data = ImageMimeData::FromClipboard();
+  FloatingSelection pasted = own_data ? own_data->selection() : FloatingSelection(PixelFormat::ToCanonical(QApplication::clipboard()->image()));
+  if (!pasted.isNull()) {
+    QPoint pos = selection_.isValid() ? selection_.topLeft() : QPoint(0, 0);
+    PutSelectionDown();
+    selection_ = QRect(pos, pasted.size());
+    floating_ = pasted;
     repaint();
   }
 }
 
 void ImageEditWidget::Delete() {
+  // Only the hole is left behind.
+  qint64 key = image_.cacheKey();
+  QRect hole = floating_.hole();
+  floating_.Commit(&image_, QRect(), active_mask());
+  undo_redo_.Touch(key, image_, hole);
   selection_ = QRect();
-  image_selection_ = QImage();
   repaint();
 }
 
 void ImageEditWidget::SelectAll() {
+  PutSelectionDown();
   selection_ = image_.rect();
-  image_selection_ = image_;
-  image_.fill(options_cache_->alt_color());
+  floating_ = FloatingSelection(image_, selection_, options_cache_->alt_color());
   repaint();
 }
 
@@ -177,15 +274,24 @@ void ImageEditWidget::paintEvent(QPaintEvent *) {
 
   painter.drawImage(image_rect, image_);
 
+  if (!mask_image_.isNull()) {
+    painter.drawImage(image_rect, mask_image_);
+  }
+
   if (action_started_) {
     painter.drawImage(image_rect, overlay_image_);
   }
 
-  QRect selection = SelectionRect(selection_);
-  if (!image_selection_.isNull()) {
-    painter.drawImage(selection.adjusted(0, 0, 1, 1), image_selection_);
+  // The lifted area is still in the image, cover it until the selection is
+  // put down.
+  QRect hole = floating_.hole();
+  if (hole.isValid()) {
+    painter.fillRect(SelectionRect(hole).adjusted(0, 0, 1, 1), floating_.hole_color());
   }
 
+  QRect selection = SelectionRect(selection_);
+  floating_.Draw(&painter, selection.adjusted(0, 0, 1, 1));
+
   // Draw Grid
   painter.setPen(QColor(0, 0, 0, 50));
   if (zoom > 1 && options_cache_->show_pixel_grid()) {
@@ -241,29 +347,22 @@ void ImageEditWidget::paintEvent(QPaintEvent *) {
 }
 
 void ImageEditWidget::mouseMoveEvent(QMouseEvent *event) {
-  int zoom = options_cache_->zoom();
-  QPoint pos = event->pos();
-
-  if (rect().contains(pos)) {
-    int z = clamp(zoom, 1, 32);
-    QPoint p = QPoint((pos.x() / z) * z, (pos.y() / z) * z);
-    int cursor_size = zoom - 1;
-    cursor_ = QRect(p, QSize(cursor_size, cursor_size));
-  } else {
-    cursor_ = QRect(0, 0, 0, 0);
+  // Only queue the sample here. The tool runs once per frame on everything
+  // gathered since the last one (see FlushPendingMoves).
+  pending_moves_.push_back(event->pos());
+  if (!frame_timer_->isActive()) {
+    frame_timer_->start();
   }
-
-  ToolAction(event, ACTION_MOVE);
-  previous_pos_ = pos;
-  update();
 }
 
 void ImageEditWidget::leaveEvent(QEvent *) {
+  FlushPendingMoves();
   cursor_ = QRect(0, 0, 0, 0);
   update();
 }
 
 void ImageEditWidget::mousePressEvent(QMouseEvent *event) {
+  FlushPendingMoves();
   previous_pos_ = event->pos();
 
   bool contains_pos = rect().contains(event->pos());
@@ -281,11 +380,13 @@ void ImageEditWidget::mousePressEvent(QMouseEvent *event) {
     break;
   }
 
-  ToolAction(event, ACTION_PRESS);
+  ToolAction(event->pos(), ACTION_PRESS, {WidgetToImageSpace(event->pos())});
   update();
 }
 
 void ImageEditWidget::mouseReleaseEvent(QMouseEvent *event) {
+  FlushPendingMoves();
+
   switch (event->button()) {
   case Qt::LeftButton:
     left_button_down_ = false;
@@ -301,16 +402,15 @@ void ImageEditWidget::mouseReleaseEvent(QMouseEvent *event) {
     mouseClickEvent(event);
   }
 
-  ToolAction(event, ACTION_RELEASE);
+  ToolAction(event->pos(), ACTION_RELEASE, {WidgetToImageSpace(event->pos())});
 }
 
 void ImageEditWidget::mouseClickEvent(QMouseEvent *event) {
-  ToolAction(event, ACTION_CLICK);
+  ToolAction(event->pos(), ACTION_CLICK, {WidgetToImageSpace(event->pos())});
 }
 
-void ImageEditWidget::ToolAction(const QMouseEvent *event, ACTION_TOOL action) {
-  QPoint pos = event->pos();
-  ToolEvent tool_event(action, left_button_down_, right_button_down_, WidgetToImageSpace(pos), WidgetToImageSpace(previous_pos_), &undo_redo_);
+void ImageEditWidget::ToolAction(const QPoint &pos, ACTION_TOOL action, const QVector<QPoint> &img_path) {
+  ToolEvent tool_event(action, left_button_down_, right_button_down_, WidgetToImageSpace(pos), WidgetToImageSpace(previous_pos_), img_path, &undo_redo_, active_mask());
 
   switch (options_cache_->tool()) {
   case TOOL_PENCIL:
@@ -329,7 +429,7 @@ void ImageEditWidget::ToolAction(const QMouseEvent *event, ACTION_TOOL action) {
     RectangleTool::Use(&image_, &overlay_image_, options_cache_->main_color(), options_cache_->alt_color(), &action_anchor_, &action_started_, tool_event);
     break;
   case TOOL_SELECTION:
-    SelectionTool::Use(&image_, &selection_, &image_selection_, options_cache_->alt_color(), &action_anchor_, &action_started_, tool_event);
+    SelectionTool::Use(&image_, &selection_, &floating_, options_cache_->alt_color(), &action_anchor_, &action_started_, tool_event);
     break;
   case TOOL_ZOOM:
     ZoomTool::Use(&zoom_area_, &action_anchor_, &action_started_, scroll_area_, tool_event);
@@ -358,21 +458,126 @@ void ImageEditWidget::GetImage(QImage *image) {
     return;
   }
 
+  // Lifted pixels belong to the image being replaced.
   selection_ = QRect();
+  floating_ = FloatingSelection();
 
   undo_redo_.Do(image_);
 
   image_ = *image;
-  overlay_image_ = QImage(image_.size(), image_.format());
+  // Tools preview on a true color overlay, also for indexed images.
+  overlay_image_ = QImage(image_.size(), PixelFormat::kTrueColor);
   overlay_image_.fill(0x0);
+  // The mask belongs to the tile it was made on, it stays while the same
+  // tile is sent back.
+  if (mask_.size() != image_.size() || mask_selection_ != options_cache_->tile_selection()) {
+    ClearMask();
+  }
 
   UpdateWidget();
 }
 
+void ImageEditWidget::AutoMask() {
+  if (image_.isNull()) {
+    return;
+  }
+  // Protects the pixels of the main color, on top of what is already
+  // protected. A selection limits the new part to its area.
+  BitMask color_mask = BitMask::FromColor(image_, IndexedColor::PixelValue(image_, options_cache_->main_color()));
+  if (selection_.isValid()) {
+    BitMask area(image_.size());
+    area.FillRect(selection_, true);
+    color_mask.Intersect(area);
+  }
+  if (mask_.size() != image_.size()) {
+    mask_ = BitMask(image_.size());
+  }
+  mask_.Unite(color_mask);
+  mask_selection_ = options_cache_->tile_selection();
+  MaskChanged();
+}
+
+void ImageEditWidget::ClearMask() {
+  mask_ = BitMask();
+  MaskChanged();
+}
+
+void ImageEditWidget::InvertMask() {
+  if (image_.isNull()) {
+    return;
+  }
+  if (mask_.size() != image_.size()) {
+    mask_ = BitMask(image_.size());
+  }
+  mask_.Invert();
+  mask_selection_ = options_cache_->tile_selection();
+  MaskChanged();
+}
+
+const BitMask *ImageEditWidget::active_mask() const {
+  return mask_.size() == image_.size() && !mask_empty_ ? &mask_ : nullptr;
+}
+
+void ImageEditWidget::PutSelectionDown() {
+  qint64 key = image_.cacheKey();
+  undo_redo_.Touch(key, image_, SelectionTool::ClearSelection(&image_, &selection_, &floating_, active_mask()));
+}
+
+void ImageEditWidget::MaskChanged() {
+  mask_empty_ = mask_.IsEmpty();
+  mask_image_ = nullptr == active_mask() ? QImage() : mask_.ToImage(kMaskColor);
+  update();
+}
+
 void ImageEditWidget::HandleRequest() {
+  // The canvas gets what is shown, so a floating selection is put down first.
+  if (!floating_.isNull() || floating_.hole().isValid()) {
+    PutSelectionDown();
+    repaint();
+  }
   emit SendImage(&image_);
 }
 
+void ImageEditWidget::FlushPendingMoves() {
+  if (pending_moves_.isEmpty()) {
+    frame_timer_->stop();
+    return;
+  }
+
+  // Build one polyline out of every sample of this frame, so tools that draw
+  // along the path (the pencil) do not lose points, while tools that only
+  // care about the latest position run just once.
+  QVector<QPoint> img_path;
+  img_path.reserve(pending_moves_.size() + 1);
+  img_path.push_back(WidgetToImageSpace(previous_pos_));
+  for (const QPoint &p : pending_moves_) {
+    QPoint img_p = WidgetToImageSpace(p);
+    if (img_p != img_path.last()) {
+      img_path.push_back(img_p);
+    }
+  }
+
+  QPoint pos = pending_moves_.last();
+  pending_moves_.clear();
+
+  int zoom = options_cache_->zoom();
+  if (rect().contains(pos)) {
+    int z = clamp(zoom, 1, 32);
+    QPoint p = QPoint((pos.x() / z) * z, (pos.y() / z) * z);
+    int cursor_size = zoom - 1;
+    cursor_ = QRect(p, QSize(cursor_size, cursor_size));
+  } else {
+    cursor_ = QRect(0, 0, 0, 0);
+  }
+
+  ToolAction(pos, ACTION_MOVE, img_path);
+  previous_pos_ = pos;
+
+  QPoint img_pos = img_path.last();
+  pApp->SetStatusMessage(QString("%1, %2").arg(img_pos.x()).arg(img_pos.y()));
+  update();
+}
+
 void ImageEditWidget::UpdateWidget() {
   int zoom = pApp->options()->zoom();
 
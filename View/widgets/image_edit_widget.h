@@ -23,11 +23,15 @@
 #include <QImage>
 #include <QWidget>
 
+#include "logic/bit_mask.h"
+#include "logic/floating_selection.h"
 #include "logic/tool_algorithm.h"
 #include "logic/undo_redo.h"
+#include "pb_scale.h"
 
 class GlobalOptions;
 class QScrollArea;
+class QTimer;
 
 /*!
  * \brief The ImageEditWidget class
@@ -41,13 +45,26 @@ public:
 
   void Undo();
   void Redo();
+  qint64 UndoTimestamp() const;
+  qint64 RedoTimestamp() const;
 
   void set_scroll_area(QScrollArea *scroll_area);
 
   void ClearSelection();
 
   void Rotate(bool cw);
+  // Any angle, clockwise. A selection grows to fit, the whole image keeps
+  // its size and loses the corners.
+  void RotateBy(double degrees);
+  // The selection, or the whole image when nothing is selected.
+  QImage selected_pixels() const;
   void Flip(bool h, bool v);
+  // Moves the image (or the selection) with wrap around, to check seams.
+  void Shift(int dx, int dy);
+  void Scale(SCALER_ENUM scaler, int factor);
+  // Drop shadow (or outline) behind the opaque pixels of the selection, or
+  // of the whole image.
+  void CreateShadow(const QPoint &offset, int radius, const QColor &color);
 protected:
   virtual void paintEvent(QPaintEvent *);
   virtual void mouseMoveEvent(QMouseEvent *event);
@@ -60,7 +77,8 @@ private:
   QImage image_;
   QRect cursor_;
 
-  QImage image_selection_;
+  // Lifted or pasted pixels, drawn over the image at |selection_|.
+  FloatingSelection floating_;
 
   UndoRedo undo_redo_;
 
@@ -81,10 +99,26 @@ private:
 
   QImage overlay_image_;
 
-  void ToolAction(const QMouseEvent *event, ACTION_TOOL action);
+  // Protected pixels of image_ and their tinted display copy.
+  BitMask mask_;
+  QImage mask_image_;
+  // No bit of mask_ is set, updated whenever it changes.
+  bool mask_empty_;
+  // Canvas tile selection the mask was made on.
+  QRect mask_selection_;
+
+  // Raw mouse move samples (widget space) waiting for the next frame.
+  QVector<QPoint> pending_moves_;
+  QTimer *frame_timer_;
+
+  void ToolAction(const QPoint &pos, ACTION_TOOL action, const QVector<QPoint> &img_path);
 
   QRect SelectionRect(const QRect &rect);
   QPoint WidgetToImageSpace(const QPoint &pos);
+  const BitMask *active_mask() const;
+  void MaskChanged();
+  // SelectionTool::ClearSelection, telling the history what changed.
+  void PutSelectionDown();
 
   QScrollArea *scroll_area_;
 signals:
@@ -93,12 +127,17 @@ public slots:
   void GetImage(QImage *image);
   void HandleRequest();
   void UpdateWidget();
+  void FlushPendingMoves();
 
   void Copy();
   void Cut();
   void Paste();
   void Delete();
   void SelectAll();
+
+  void AutoMask();
+  void ClearMask();
+  void InvertMask();
 };
 
 #endif // IMAGE_EDIT_WIDGET_H
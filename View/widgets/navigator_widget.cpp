@@ -0,0 +1,174 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "navigator_widget.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include "application/pixel_booster.h"
+#include "utils/debug.h"
+#include "widgets/image_canvas_container.h"
+#include "widgets/image_canvas_widget.h"
+#include "pb_math.h"
+
+const qreal kNavigatorMinZoom = 1.0;
+const qreal kNavigatorMaxZoom = 64.0;
+
+NavigatorWidget::NavigatorWidget(QWidget *parent)
+    : QWidget(parent),
+      options_cache_(pApp->options()),
+      zoom_(1.0),
+      scrolling_(false),
+      panning_(false) {
+  setMinimumSize(64, 64);
+}
+
+void NavigatorWidget::SetCanvas(ImageCanvasContainer *container) {
+  if (!canvas_.isNull()) {
+    QObject::disconnect(canvas_, 0, this, 0);
+  }
+  if (!container_.isNull()) {
+    QObject::disconnect(container_->horizontalScrollBar(), 0, this, 0);
+    QObject::disconnect(container_->verticalScrollBar(), 0, this, 0);
+  }
+
+  container_ = container;
+  canvas_ = container ? container->GetCanvasWidget() : nullptr;
+  zoom_ = 1.0;
+
+  if (!canvas_.isNull()) {
+    QObject::connect(canvas_, SIGNAL(ImageChanged(QRect)), this, SLOT(CanvasChanged()));
+    QObject::connect(canvas_, SIGNAL(TileCursorMoved()), this, SLOT(CanvasChanged()));
+    QObject::connect(canvas_, SIGNAL(ZoomChanged(qreal)), this, SLOT(CanvasChanged()));
+    QObject::connect(container_->horizontalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(CanvasChanged()));
+    QObject::connect(container_->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(CanvasChanged()));
+    center_ = QRectF(canvas_->image_rect()).center();
+  }
+  update();
+}
+
+void NavigatorWidget::CanvasChanged() {
+  update();
+}
+
+void NavigatorWidget::paintEvent(QPaintEvent *) {
+  QPainter painter(this);
+  painter.fillRect(rect(), Qt::darkGray);
+
+  if (canvas_.isNull() || canvas_->image_rect().isEmpty()) {
+    return;
+  }
+
+  // The canvas picks the pyramid level closest above the overview scale, or
+  // the allocated tiles of a sparse document, and draws only the part of it
+  // that falls inside the widget.
+  QRectF visible = QRectF(WidgetToImage(rect().topLeft()), WidgetToImage(rect().bottomRight() + QPoint(1, 1)));
+  visible = visible.intersected(QRectF(canvas_->image_rect()));
+  if (!visible.isEmpty()) {
+    canvas_->DrawImageRect(&painter, visible, ImageToWidget(visible));
+  }
+
+  // Part of the image currently shown by the canvas window.
+  painter.setBrush(Qt::NoBrush);
+  painter.setPen(Qt::white);
+  painter.drawRect(ImageToWidget(VisibleCanvasRect()));
+
+  painter.setPen(Qt::red);
+  painter.drawRect(ImageToWidget(options_cache_->tile_selection()));
+}
+
+void NavigatorWidget::mousePressEvent(QMouseEvent *event) {
+  if (canvas_.isNull()) {
+    return;
+  }
+  if (event->button() == Qt::LeftButton) {
+    scrolling_ = true;
+    ScrollCanvasTo(WidgetToImage(event->pos()));
+  } else {
+    panning_ = true;
+    pan_anchor_ = event->pos();
+  }
+}
+
+void NavigatorWidget::mouseMoveEvent(QMouseEvent *event) {
+  if (canvas_.isNull()) {
+    return;
+  }
+  if (scrolling_) {
+    ScrollCanvasTo(WidgetToImage(event->pos()));
+  } else if (panning_) {
+    QPoint delta = event->pos() - pan_anchor_;
+    center_ = center_ - QPointF(delta) / Scale();
+    pan_anchor_ = event->pos();
+    update();
+  }
+}
+
+void NavigatorWidget::mouseReleaseEvent(QMouseEvent *) {
+  scrolling_ = false;
+  panning_ = false;
+}
+
+void NavigatorWidget::wheelEvent(QWheelEvent *event) {
+  if (canvas_.isNull()) {
+    return;
+  }
+  // Zoom around the pixel under the mouse.
+  QPointF anchor = WidgetToImage(event->pos());
+  qreal factor = event->delta() > 0 ? 2.0 : 0.5;
+  zoom_ = clamp(zoom_ * factor, kNavigatorMinZoom, kNavigatorMaxZoom);
+  if (zoom_ == kNavigatorMinZoom) {
+    center_ = QRectF(canvas_->image_rect()).center();
+  } else {
+    center_ = anchor - (QPointF(event->pos()) - QRectF(rect()).center()) / Scale();
+  }
+  update();
+}
+
+qreal NavigatorWidget::Scale() const {
+  QRect image_rect = canvas_->image_rect();
+  qreal fit = qMin(qreal(width()) / image_rect.width(), qreal(height()) / image_rect.height());
+  return fit * zoom_;
+}
+
+QPointF NavigatorWidget::WidgetToImage(const QPoint &pos) const {
+  return center_ + (QPointF(pos) - QRectF(rect()).center()) / Scale();
+}
+
+QRectF NavigatorWidget::ImageToWidget(const QRectF &rect) const {
+  qreal scale = Scale();
+  QPointF top_left = (rect.topLeft() - center_) * scale + QRectF(this->rect()).center();
+  return QRectF(top_left, QSizeF(rect.width() * scale, rect.height() * scale));
+}
+
+QRect NavigatorWidget::VisibleCanvasRect() const {
+  QWidget *viewport = container_->viewport();
+  QRect visible = QRect(canvas_->mapFrom(viewport, QPoint(0, 0)), viewport->size());
+  return canvas_->WidgetToImage(visible.intersected(canvas_->rect()));
+}
+
+void NavigatorWidget::ScrollCanvasTo(const QPointF &image_pos) {
+  QPoint widget_pos = canvas_->ImageToWidget(QRect(image_pos.toPoint(), QSize(1, 1))).topLeft();
+  QPoint pos = canvas_->mapTo(container_->widget(), widget_pos);
+  QWidget *viewport = container_->viewport();
+  container_->horizontalScrollBar()->setValue(pos.x() - viewport->width() / 2);
+  container_->verticalScrollBar()->setValue(pos.y() - viewport->height() / 2);
+}
@@ -0,0 +1,76 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef NAVIGATOR_WIDGET_H
+#define NAVIGATOR_WIDGET_H
+
+#include <QPointer>
+#include <QWidget>
+
+class GlobalOptions;
+class ImageCanvasContainer;
+class ImageCanvasWidget;
+
+/*!
+ * \brief Downscaled overview of the active canvas.
+ *
+ * Left click/drag scrolls the canvas to that point, the wheel zooms the
+ * overview and right/middle drag pans it. Drawing picks the mipmap level that
+ * matches the overview scale, so it only touches the visible pixels.
+ */
+class NavigatorWidget : public QWidget {
+  Q_OBJECT
+public:
+  explicit NavigatorWidget(QWidget *parent = 0);
+
+  void SetCanvas(ImageCanvasContainer *container);
+
+protected:
+  virtual void paintEvent(QPaintEvent *);
+  virtual void mousePressEvent(QMouseEvent *event);
+  virtual void mouseMoveEvent(QMouseEvent *event);
+  virtual void mouseReleaseEvent(QMouseEvent *event);
+  virtual void wheelEvent(QWheelEvent *event);
+
+private:
+  GlobalOptions *options_cache_;
+
+  QPointer<ImageCanvasContainer> container_;
+  QPointer<ImageCanvasWidget> canvas_;
+
+  // Overview zoom relative to fitting the whole image, and the image point
+  // shown at the center of the widget.
+  qreal zoom_;
+  QPointF center_;
+
+  bool scrolling_;
+  bool panning_;
+  QPoint pan_anchor_;
+
+  qreal Scale() const;
+  QPointF WidgetToImage(const QPoint &pos) const;
+  QRectF ImageToWidget(const QRectF &rect) const;
+  QRect VisibleCanvasRect() const;
+  void ScrollCanvasTo(const QPointF &image_pos);
+
+public slots:
+  void CanvasChanged();
+};
+
+#endif // NAVIGATOR_WIDGET_H
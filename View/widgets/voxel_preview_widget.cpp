@@ -0,0 +1,66 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#include "voxel_preview_widget.h"
+
+#include <QPainter>
+
+#include "widgets/image_canvas_widget.h"
+
+VoxelPreviewWidget::VoxelPreviewWidget(QWidget *parent) : QWidget(parent) {
+  setMinimumSize(64, 64);
+}
+
+void VoxelPreviewWidget::SetCanvas(ImageCanvasWidget *canvas) {
+  if (!canvas_.isNull()) {
+    QObject::disconnect(canvas_, 0, this, 0);
+  }
+  canvas_ = canvas;
+  if (!canvas_.isNull()) {
+    QObject::connect(canvas_, SIGNAL(ImageChanged(QRect)), this, SLOT(CanvasChanged()));
+  }
+  update();
+}
+
+void VoxelPreviewWidget::CanvasChanged() {
+  if (!canvas_.isNull() && canvas_->voxel_mode()) {
+    update();
+  }
+}
+
+void VoxelPreviewWidget::paintEvent(QPaintEvent *) {
+  QPainter painter(this);
+  painter.fillRect(rect(), Qt::darkGray);
+
+  if (canvas_.isNull() || !canvas_->voxel_mode()) {
+    return;
+  }
+
+  // Rendering happens here, so edits made while the dock is hidden cost
+  // nothing until it is shown again.
+  const QImage &preview = canvas_->VoxelPreview();
+  QSize size = preview.size().scaled(this->size(), Qt::KeepAspectRatio);
+  if (size.width() >= preview.width()) {
+    // Whole pixel zoom keeps the voxel faces sharp.
+    size = preview.size() * qMax(1, qMin(width() / preview.width(), height() / preview.height()));
+  }
+  QRect target(QPoint(), size);
+  target.moveCenter(rect().center());
+  painter.drawImage(target, preview);
+}
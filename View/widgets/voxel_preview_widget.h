@@ -0,0 +1,48 @@
+/***************************************************************************\
+*  Pixel::Booster, a simple pixel art image editor.                         *
+*  Copyright (C) 2015  Ricardo Bustamante de Queiroz (ricardo@busta.com.br) *
+*  Visit the Official Homepage: pixel.busta.com.br                          *
+*                                                                           *
+*  This program is free software: you can redistribute it and/or modify     *
+*  it under the terms of the GNU General Public License as published by     *
+*  the Free Software Foundation, either version 3 of the License, or        *
+*  (at your option) any later version.                                      *
+*                                                                           *
+*  This program is distributed in the hope that it will be useful,          *
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of           *
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            *
+*  GNU General Public License for more details.                             *
+*                                                                           *
+*  You should have received a copy of the GNU General Public License        *
+*  along with this program.  If not, see <http://www.gnu.org/licenses/>.    *
+\***************************************************************************/
+
+#ifndef VOXEL_PREVIEW_WIDGET_H
+#define VOXEL_PREVIEW_WIDGET_H
+
+#include <QPointer>
+#include <QWidget>
+
+class ImageCanvasWidget;
+
+/*!
+ * \brief Shows the isometric view of the voxel model of the active canvas.
+ */
+class VoxelPreviewWidget : public QWidget {
+  Q_OBJECT
+public:
+  explicit VoxelPreviewWidget(QWidget *parent = 0);
+
+  void SetCanvas(ImageCanvasWidget *canvas);
+
+protected:
+  virtual void paintEvent(QPaintEvent *);
+
+private:
+  QPointer<ImageCanvasWidget> canvas_;
+
+private slots:
+  void CanvasChanged();
+};
+
+#endif // VOXEL_PREVIEW_WIDGET_H